@@ -79,6 +79,9 @@ __flameshot_complete gui -l "clipboard"         -s "c"  -f   -d "Copy screenshot
 __flameshot_complete gui -l "delay"             -s "d"  -frk -d "Delay time in milliseconds"
 __flameshot_complete gui -l "region"                    -frk -d "Screenshot region to select (WxH+X+Y)" -a "(__flameshot_complete_region gui)"
 __flameshot_complete gui -l "raw"               -s "r"  -f   -d "Print raw PNG capture"
+__flameshot_complete gui -l "raw-format"                -frk -d "Image format of the raw capture" -a "png ppm qoi rgba webp jpg bmp"
+__flameshot_complete gui -l "max-size"                  -frk -d "Downscale the exported capture (WxH)"
+__flameshot_complete gui -l "trim"                      -f   -d "Crop the uniform borders of the exported capture"
 __flameshot_complete gui -l "print-geometry"    -s "g"  -f   -d "Print geometry of the selection"
 __flameshot_complete gui -l "upload"            -s "u"  -f   -d "Upload the screenshot"
 __flameshot_complete gui -l "pin"                       -f   -d "Pin the screenshot to the screen"
@@ -92,6 +95,9 @@ __flameshot_complete screen -l "clipboard"      -s "c"  -f   -d "Copy screenshot
 __flameshot_complete screen -l "delay"          -s "d"  -frk -d "Delay time in milliseconds"
 __flameshot_complete screen -l "region"                 -frk -d "Screenshot region to select (WxH+X+Y)" -a "(__flameshot_complete_region screen)"
 __flameshot_complete screen -l "raw"            -s "r"  -f   -d "Print raw PNG capture"
+__flameshot_complete screen -l "raw-format"             -frk -d "Image format of the raw capture" -a "png ppm qoi rgba webp jpg bmp"
+__flameshot_complete screen -l "max-size"               -frk -d "Downscale the exported capture (WxH)"
+__flameshot_complete screen -l "trim"                   -f   -d "Crop the uniform borders of the exported capture"
 __flameshot_complete screen -l "upload"         -s "u"  -f   -d "Upload the screenshot"
 __flameshot_complete screen -l "pin"                    -f   -d "Pin the screenshot to the screen"
 
@@ -102,6 +108,9 @@ __flameshot_complete full   -l "clipboard"      -s "c"  -f   -d "Copy screenshot
 __flameshot_complete full   -l "delay"          -s "d"  -frk -d "Delay time in milliseconds"
 __flameshot_complete full   -l "region"                 -frk -d "Screenshot region to select (WxH+X+Y)" -a "(__flameshot_complete_region full)"
 __flameshot_complete full   -l "raw"            -s "r"  -f   -d "Print raw PNG capture"
+__flameshot_complete full   -l "raw-format"             -frk -d "Image format of the raw capture" -a "png ppm qoi rgba webp jpg bmp"
+__flameshot_complete full   -l "max-size"               -frk -d "Downscale the exported capture (WxH)"
+__flameshot_complete full   -l "trim"                   -f   -d "Crop the uniform borders of the exported capture"
 __flameshot_complete full   -l "upload"         -s "u"  -f   -d "Upload the screenshot"
 
 # LAUNCHER command doesn't have any completions specific to itself
@@ -3,6 +3,7 @@
 #include "generalconf.h"
 #include "src/core/flameshot.h"
 #include "src/utils/confighandler.h"
+#include "src/utils/valuehandler.h"
 #include <QCheckBox>
 #include <QComboBox>
 #include <QFile>
@@ -24,6 +25,7 @@ GeneralConf::GeneralConf(QWidget* parent)
   : QWidget(parent)
   , m_historyConfirmationToDelete(nullptr)
   , m_undoLimit(nullptr)
+  , m_undoMemoryLimit(nullptr)
 {
     m_layout = new QVBoxLayout(this);
     m_layout->setAlignment(Qt::AlignTop);
@@ -47,6 +49,9 @@ GeneralConf::GeneralConf(QWidget* parent)
     initShowHelp();
     initShowSidePanelButton();
     initUseJpgForClipboard();
+    initIndexedPng();
+    initWebpLossless();
+    initTrimBorders();
     initCopyOnDoubleClick();
     initSaveAfterCopy();
     initCopyPathAfterSave();
@@ -56,6 +61,7 @@ GeneralConf::GeneralConf(QWidget* parent)
     initAntialiasingPinZoom();
     initUploadHistoryMax();
     initUndoLimit();
+    initUndoMemoryLimit();
     initUploadClientSecret();
     initPredefinedColorPaletteLarge();
     initShowSelectionGeometry();
@@ -65,6 +71,8 @@ GeneralConf::GeneralConf(QWidget* parent)
     initShowMagnifier();
     initSquareMagnifier();
     initJpegQuality();
+    initPngCompressionLevel();
+    initExportMaxSize();
     // this has to be at the end
     initConfigButtons();
     updateComponents();
@@ -82,6 +90,11 @@ void GeneralConf::_updateComponents(bool allowEmptySavePath)
     m_copyPathAfterSave->setChecked(config.copyPathAfterSave());
     m_antialiasingPinZoom->setChecked(config.antialiasingPinZoom());
     m_useJpgForClipboard->setChecked(config.useJpgForClipboard());
+    m_indexedPngForSave->setChecked(config.indexedPngForSave());
+    m_indexedPngForClipboard->setChecked(config.indexedPngForClipboard());
+    m_indexedPngForUpload->setChecked(config.indexedPngForUpload());
+    m_webpLossless->setChecked(config.webpLossless());
+    m_trimBorders->setChecked(config.trimBorders());
     m_copyOnDoubleClick->setChecked(config.copyOnDoubleClick());
     m_uploadWithoutConfirmation->setChecked(config.uploadWithoutConfirmation());
     m_historyConfirmationToDelete->setChecked(
@@ -104,6 +117,9 @@ void GeneralConf::_updateComponents(bool allowEmptySavePath)
     m_screenshotPathFixedCheck->setChecked(config.savePathFixed());
     m_uploadHistoryMax->setValue(config.uploadHistoryMax());
     m_undoLimit->setValue(config.undoLimit());
+    m_undoMemoryLimit->setValue(config.undoMemoryLimit());
+    m_exportMaxSize->setText(
+      MaxSize().representation(config.exportMaxSize()).toString());
 
     if (allowEmptySavePath || !config.savePath().isEmpty()) {
         m_savePath->setText(config.savePath());
@@ -606,6 +622,35 @@ void GeneralConf::undoLimit(int limit)
     ConfigHandler().setUndoLimit(limit);
 }
 
+void GeneralConf::initUndoMemoryLimit()
+{
+    auto* box = new QGroupBox(tr("Undo memory limit (MiB, 0 for no limit)"));
+    box->setFlat(true);
+    m_layout->addWidget(box);
+
+    auto* vboxLayout = new QVBoxLayout();
+    box->setLayout(vboxLayout);
+
+    m_undoMemoryLimit = new QSpinBox(this);
+    m_undoMemoryLimit->setMinimum(0);
+    m_undoMemoryLimit->setMaximum(4096);
+    QString foreground = this->palette().windowText().color().name();
+    m_undoMemoryLimit->setStyleSheet(
+      QStringLiteral("color: %1").arg(foreground));
+
+    connect(m_undoMemoryLimit,
+            static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+            this,
+            &GeneralConf::undoMemoryLimit);
+
+    vboxLayout->addWidget(m_undoMemoryLimit);
+}
+
+void GeneralConf::undoMemoryLimit(int limit)
+{
+    ConfigHandler().setUndoMemoryLimit(limit);
+}
+
 void GeneralConf::initUseJpgForClipboard()
 {
     m_useJpgForClipboard =
@@ -675,6 +720,60 @@ void GeneralConf::initUploadWithoutConfirmation()
     });
 }
 
+void GeneralConf::initIndexedPng()
+{
+    const QString tooltip =
+      tr("Encode PNG with a palette of up to 256 colors for much smaller "
+         "files, captures with more colors lose some of them");
+
+    m_indexedPngForSave =
+      new QCheckBox(tr("Use indexed PNG for saved files"), this);
+    m_indexedPngForSave->setToolTip(tooltip);
+    m_scrollAreaLayout->addWidget(m_indexedPngForSave);
+    connect(m_indexedPngForSave, &QCheckBox::clicked, [](bool checked) {
+        ConfigHandler().setIndexedPngForSave(checked);
+    });
+
+    m_indexedPngForClipboard =
+      new QCheckBox(tr("Use indexed PNG for clipboard"), this);
+    m_indexedPngForClipboard->setToolTip(tooltip);
+    m_scrollAreaLayout->addWidget(m_indexedPngForClipboard);
+    connect(m_indexedPngForClipboard, &QCheckBox::clicked, [](bool checked) {
+        ConfigHandler().setIndexedPngForClipboard(checked);
+    });
+
+    m_indexedPngForUpload =
+      new QCheckBox(tr("Use indexed PNG for uploads"), this);
+    m_indexedPngForUpload->setToolTip(tooltip);
+    m_scrollAreaLayout->addWidget(m_indexedPngForUpload);
+    connect(m_indexedPngForUpload, &QCheckBox::clicked, [](bool checked) {
+        ConfigHandler().setIndexedPngForUpload(checked);
+    });
+}
+
+void GeneralConf::initWebpLossless()
+{
+    m_webpLossless = new QCheckBox(tr("Use lossless WebP"), this);
+    m_webpLossless->setToolTip(
+      tr("Encode WebP captures without any loss, in larger files"));
+    m_scrollAreaLayout->addWidget(m_webpLossless);
+    connect(m_webpLossless, &QCheckBox::clicked, [](bool checked) {
+        ConfigHandler().setWebpLossless(checked);
+    });
+}
+
+void GeneralConf::initTrimBorders()
+{
+    m_trimBorders = new QCheckBox(tr("Trim uniform borders on export"), this);
+    m_trimBorders->setToolTip(
+      tr("Crop the borders of the color of the top left pixel from saved, "
+         "copied and uploaded captures"));
+    m_scrollAreaLayout->addWidget(m_trimBorders);
+    connect(m_trimBorders, &QCheckBox::clicked, [](bool checked) {
+        ConfigHandler().setTrimBorders(checked);
+    });
+}
+
 const QString GeneralConf::chooseFolder(const QString& pathDefault)
 {
     QString path;
@@ -799,6 +898,57 @@ void GeneralConf::initJpegQuality()
             &GeneralConf::setJpegQuality);
 }
 
+void GeneralConf::initPngCompressionLevel()
+{
+    auto* tobox = new QHBoxLayout();
+
+    int level = ConfigHandler().value("pngCompressionLevel").toInt();
+    m_pngCompressionLevel = new QSpinBox();
+    m_pngCompressionLevel->setRange(0, 9);
+    m_pngCompressionLevel->setToolTip(
+      tr("Compression level of 0-9; Higher number is smaller file size and "
+         "slower saving"));
+    m_pngCompressionLevel->setValue(level);
+    tobox->addWidget(m_pngCompressionLevel);
+    tobox->addWidget(new QLabel(tr("PNG Compression Level")));
+
+    m_scrollAreaLayout->addLayout(tobox);
+    connect(m_pngCompressionLevel,
+            static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+            this,
+            &GeneralConf::setPngCompressionLevel);
+}
+
+void GeneralConf::initExportMaxSize()
+{
+    auto* tobox = new QHBoxLayout();
+
+    m_exportMaxSize = new QLineEdit(this);
+    m_exportMaxSize->setPlaceholderText(tr("No limit"));
+    m_exportMaxSize->setToolTip(
+      tr("Saved, copied and uploaded captures larger than this (WxH) are "
+         "downscaled to fit"));
+    tobox->addWidget(m_exportMaxSize);
+    tobox->addWidget(new QLabel(tr("Maximum Export Size")));
+
+    m_scrollAreaLayout->addLayout(tobox);
+    connect(m_exportMaxSize,
+            &QLineEdit::editingFinished,
+            this,
+            &GeneralConf::exportMaxSizeEdited);
+}
+
+void GeneralConf::exportMaxSizeEdited()
+{
+    QString text = m_exportMaxSize->text().trimmed();
+    if (MaxSize().check(text)) {
+        ConfigHandler().setExportMaxSize(MaxSize().value(text).toSize());
+    }
+    // Shows the size that is actually used
+    m_exportMaxSize->setText(
+      MaxSize().representation(ConfigHandler().exportMaxSize()).toString());
+}
+
 void GeneralConf::setSelGeoHideTime(int v)
 {
     ConfigHandler().setValue("showSelectionGeometryHideTime", v);
@@ -809,6 +959,11 @@ void GeneralConf::setJpegQuality(int v)
     ConfigHandler().setJpegQuality(v);
 }
 
+void GeneralConf::setPngCompressionLevel(int v)
+{
+    ConfigHandler().setPngCompressionLevel(v);
+}
+
 void GeneralConf::setGeometryLocation(int index)
 {
     ConfigHandler().setValue("showSelectionGeometry",
@@ -46,6 +46,7 @@ private slots:
     void historyConfirmationToDelete(bool checked);
     void uploadHistoryMaxChanged(int max);
     void undoLimit(int limit);
+    void undoMemoryLimit(int limit);
     void saveAfterCopyChanged(bool checked);
     void changeSavePath();
     void importConfiguration();
@@ -58,6 +59,8 @@ private slots:
     void setGeometryLocation(int index);
     void setSelGeoHideTime(int v);
     void setJpegQuality(int v);
+    void setPngCompressionLevel(int v);
+    void exportMaxSizeEdited();
 
 private:
     const QString chooseFolder(const QString& currentPath = "");
@@ -85,13 +88,19 @@ private:
     void initShowTrayIcon();
     void initSquareMagnifier();
     void initUndoLimit();
+    void initUndoMemoryLimit();
     void initUploadWithoutConfirmation();
     void initUseJpgForClipboard();
+    void initIndexedPng();
+    void initWebpLossless();
+    void initTrimBorders();
     void initUploadHistoryMax();
     void initUploadClientSecret();
     void initSaveLastRegion();
     void initShowSelectionGeometry();
     void initJpegQuality();
+    void initPngCompressionLevel();
+    void initExportMaxSize();
 
     void _updateComponents(bool allowEmptySavePath);
 
@@ -125,8 +134,14 @@ private:
     QCheckBox* m_screenshotPathFixedCheck;
     QCheckBox* m_historyConfirmationToDelete;
     QCheckBox* m_useJpgForClipboard;
+    QCheckBox* m_indexedPngForSave;
+    QCheckBox* m_indexedPngForClipboard;
+    QCheckBox* m_indexedPngForUpload;
+    QCheckBox* m_webpLossless;
+    QCheckBox* m_trimBorders;
     QSpinBox* m_uploadHistoryMax;
     QSpinBox* m_undoLimit;
+    QSpinBox* m_undoMemoryLimit;
     QComboBox* m_setSaveAsFileExtension;
     QCheckBox* m_predefinedColorPaletteLarge;
     QCheckBox* m_showMagnifier;
@@ -136,4 +151,6 @@ private:
     QComboBox* m_selectGeometryLocation;
     QSpinBox* m_xywhTimeout;
     QSpinBox* m_jpegQuality;
+    QSpinBox* m_pngCompressionLevel;
+    QLineEdit* m_exportMaxSize;
 };
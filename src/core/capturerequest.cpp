@@ -42,6 +42,29 @@ QString CaptureRequest::path() const
     return m_path;
 }
 
+QString CaptureRequest::rawFormat() const
+{
+    return m_rawFormat;
+}
+
+/**
+ * @brief Size the exported capture is downscaled to fit in, invalid if
+ * the `exportMaxSize` setting applies.
+ */
+QSize CaptureRequest::maxSize() const
+{
+    return m_maxSize;
+}
+
+/**
+ * @brief Whether the uniform borders of the exported capture are cropped,
+ * along with the `trimBorders` setting.
+ */
+bool CaptureRequest::trimBorders() const
+{
+    return m_trimBorders;
+}
+
 QVariant CaptureRequest::data() const
 {
     return m_data;
@@ -76,6 +99,12 @@ void CaptureRequest::addSaveTask(const QString& path)
     m_path = path;
 }
 
+void CaptureRequest::addPrintRawTask(const QString& format)
+{
+    m_tasks |= PRINT_RAW;
+    m_rawFormat = format;
+}
+
 void CaptureRequest::addPinTask(const QRect& pinWindowGeometry)
 {
     m_tasks |= PIN;
@@ -86,3 +115,13 @@ void CaptureRequest::setInitialSelection(const QRect& selection)
 {
     m_initialSelection = selection;
 }
+
+void CaptureRequest::setMaxSize(const QSize& size)
+{
+    m_maxSize = size;
+}
+
+void CaptureRequest::setTrimBorders(bool trim)
+{
+    m_trimBorders = trim;
+}
@@ -39,6 +39,9 @@ public:
     uint id() const;
     uint delay() const;
     QString path() const;
+    QString rawFormat() const;
+    QSize maxSize() const;
+    bool trimBorders() const;
     QVariant data() const;
     CaptureMode captureMode() const;
     ExportTask tasks() const;
@@ -47,16 +50,22 @@ public:
     void addTask(ExportTask task);
     void removeTask(ExportTask task);
     void addSaveTask(const QString& path = QString());
+    void addPrintRawTask(const QString& format = QStringLiteral("png"));
     void addPinTask(const QRect& pinWindowGeometry);
     void setInitialSelection(const QRect& selection);
+    void setMaxSize(const QSize& size);
+    void setTrimBorders(bool trim);
 
 private:
     CaptureMode m_mode;
     uint m_delay;
     QString m_path;
+    QString m_rawFormat = QStringLiteral("png");
     ExportTask m_tasks;
     QVariant m_data;
     QRect m_pinWindowGeometry, m_initialSelection;
+    QSize m_maxSize;
+    bool m_trimBorders = false;
 
     CaptureRequest() {}
 };
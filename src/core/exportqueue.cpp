@@ -0,0 +1,100 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "exportqueue.h"
+#include <QCoreApplication>
+#include <QRunnable>
+#include <utility>
+
+class ExportQueue::Job : public QRunnable
+{
+public:
+    Job(ExportQueue* queue, quint64 id, std::function<void()> job)
+      : m_queue(queue)
+      , m_id(id)
+      , m_job(std::move(job))
+    {}
+
+    void run() override
+    {
+        m_job();
+        {
+            // The runnable is deleted on this thread, the job is released
+            // by finishJob instead
+            QMutexLocker locker(&m_queue->m_finishedMutex);
+            m_queue->m_finished[m_id].swap(m_job);
+        }
+        // Queued to the GUI thread, where the queue lives
+        emit m_queue->jobFinished(m_id);
+    }
+
+private:
+    ExportQueue* m_queue;
+    quint64 m_id;
+    std::function<void()> m_job;
+};
+
+ExportQueue::ExportQueue()
+  : m_nextId(0)
+{
+    // A single worker keeps the jobs ordered and bounds the memory used by
+    // captures waiting to be encoded
+    m_pool.setMaxThreadCount(1);
+    connect(this,
+            &ExportQueue::jobFinished,
+            this,
+            &ExportQueue::finishJob,
+            Qt::QueuedConnection);
+    connect(qApp,
+            &QCoreApplication::aboutToQuit,
+            this,
+            &ExportQueue::waitForDone);
+}
+
+ExportQueue* ExportQueue::instance()
+{
+    static ExportQueue queue;
+    return &queue;
+}
+
+/**
+ * @brief Run `job` on the export thread, then `done` on the GUI thread.
+ */
+void ExportQueue::enqueue(const std::function<void()>& job,
+                          const std::function<void()>& done)
+{
+    quint64 id = m_nextId++;
+    if (done) {
+        m_done.insert(id, done);
+    }
+    m_pool.start(new Job(this, id, job));
+}
+
+/**
+ * @brief Block until every queued job has run, along with its completion
+ * callback.
+ */
+void ExportQueue::waitForDone()
+{
+    m_pool.waitForDone();
+    // Deliver the completions that are still queued, the event loop may
+    // not run again
+    QCoreApplication::sendPostedEvents(this, QEvent::MetaCall);
+}
+
+/**
+ * @brief Run the completion callback of job `id`, and release both on the
+ * GUI thread.
+ */
+void ExportQueue::finishJob(quint64 id)
+{
+    std::function<void()> job;
+    {
+        QMutexLocker locker(&m_finishedMutex);
+        job = m_finished.take(id);
+    }
+    std::function<void()> done = m_done.take(id);
+    if (done) {
+        done();
+    }
+}
@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QThreadPool>
+#include <functional>
+
+/**
+ * @brief Runs the slow parts of exporting a capture (encoding, writing files)
+ * off the GUI thread.
+ *
+ * Jobs run one after the other on a single worker thread, in the order they
+ * were queued. Once a job is done, its completion callback runs on the GUI
+ * thread, which is where notifications are sent and widgets touched.
+ *
+ * A job must not touch `QPixmap`s, widgets or `ConfigHandler`: hand it the
+ * capture as a `QImage` or an `EncodedCapture` (after calling its `image()`)
+ * and read the configuration before queuing it. Once it has run, the job is
+ * released on the GUI thread along with its completion callback, so the
+ * captures it holds may still share a `QPixmap` with the GUI.
+ *
+ * Pending jobs are completed before the application quits.
+ */
+class ExportQueue : public QObject
+{
+    Q_OBJECT
+public:
+    static ExportQueue* instance();
+
+    void enqueue(const std::function<void()>& job,
+                 const std::function<void()>& done = nullptr);
+    void waitForDone();
+
+signals:
+    void jobFinished(quint64 id);
+
+private:
+    class Job;
+
+    ExportQueue();
+
+    void finishJob(quint64 id);
+
+    QThreadPool m_pool;
+    QHash<quint64, std::function<void()>> m_done;
+    // Jobs that have run, handed back by the export thread
+    QMutex m_finishedMutex;
+    QHash<quint64, std::function<void()>> m_finished;
+    quint64 m_nextId;
+};
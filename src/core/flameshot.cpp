@@ -14,7 +14,10 @@
 #include "src/core/qguiappcurrentscreen.h"
 #include "src/tools/imgupload/imguploadermanager.h"
 #include "src/tools/imgupload/storages/imguploaderbase.h"
+#include "src/utils/bordertrimmer.h"
 #include "src/utils/confighandler.h"
+#include "src/utils/filenamehandler.h"
+#include "src/utils/imagescaler.h"
 #include "src/utils/screengrabber.h"
 #include "src/widgets/capture/capturewidget.h"
 #include "src/widgets/capturelauncher.h"
@@ -32,6 +35,7 @@
 #include <QTimer>
 #include <QUrl>
 #include <QVersionNumber>
+#include <cstdio>
 
 #if defined(Q_OS_MACOS)
 #include <QScreen>
@@ -155,18 +159,28 @@ void Flameshot::screen(CaptureRequest req, const int screenNumber)
     } else {
         screen = qApp->screens()[screenNumber];
     }
-    QPixmap p(ScreenGrabber().grabScreen(screen, ok));
-    if (ok) {
-        QRect geometry = ScreenGrabber().screenGeometry(screen);
-        QRect region = req.initialSelection();
-        if (region.isNull()) {
-            region = ScreenGrabber().screenGeometry(screen);
-        } else {
-            QRect screenGeom = ScreenGrabber().screenGeometry(screen);
-            screenGeom.moveTopLeft({ 0, 0 });
-            region = region.intersected(screenGeom);
-            p = p.copy(region);
+    ScreenGrabber grabber;
+    QRect geometry = grabber.screenGeometry(screen);
+    QRect region = req.initialSelection();
+    QPixmap p;
+    if (region.isNull()) {
+        region = geometry;
+        p = grabber.grabScreen(screen, ok);
+    } else {
+        // Only capture the requested part of the screen
+        QRect screenGeom = geometry;
+        screenGeom.moveTopLeft({ 0, 0 });
+        region = region.intersected(screenGeom);
+        if (region.isEmpty()) {
+            emit captureFailed();
+            return;
         }
+        p = grabber.grabRegion(
+          region.translated(geometry.topLeft() -
+                            grabber.desktopGeometry().topLeft()),
+          ok);
+    }
+    if (ok) {
         if (req.tasks() & CaptureRequest::PIN) {
             // change geometry for pin task
             req.addPinTask(region);
@@ -184,10 +198,12 @@ void Flameshot::full(const CaptureRequest& req)
     }
 
     bool ok = true;
-    QPixmap p(ScreenGrabber().grabEntireDesktop(ok));
+    QPixmap p;
     QRect region = req.initialSelection();
-    if (!region.isNull()) {
-        p = p.copy(region);
+    if (region.isNull()) {
+        p = ScreenGrabber().grabEntireDesktop(ok);
+    } else {
+        p = ScreenGrabber().grabRegion(region, ok);
     }
     if (ok) {
         QRect selection; // `flameshot full` does not support --selection
@@ -360,27 +376,75 @@ void Flameshot::exportCapture(const QPixmap& capture,
           << selection.x() << "+" << selection.y() << "\n";
     }
 
+    // Each format is encoded only once, whichever tasks need it. The
+    // exports may be trimmed and downscaled, the pin keeps the full capture.
+    ConfigHandler config;
+    bool trim = req.trimBorders() || config.trimBorders();
+    QSize maxSize =
+      req.maxSize().isValid() ? req.maxSize() : config.exportMaxSize();
+    EncodedCapture encoded(capture);
+    if (trim || maxSize.isValid()) {
+        QImage image = capture.toImage();
+        if (trim) {
+            image = BorderTrimmer::trimmed(image);
+        }
+        encoded = EncodedCapture(ImageScaler::fitted(image, maxSize));
+    }
+
+    // Only the formats written by several tasks are kept in memory
+    QString extension = config.saveAsFileExtension();
+    QStringList formats;
     if (tasks & CR::PRINT_RAW) {
-        QByteArray byteArray;
-        QBuffer buffer(&byteArray);
-        capture.save(&buffer, "PNG");
-        QFile file;
-        file.open(stdout, QIODevice::WriteOnly);
+        formats << req.rawFormat();
+    }
+    if (tasks & CR::SAVE) {
+        // The dialog offers the configured extension first
+        QString name = "capture." + extension;
+        if (!path.isEmpty()) {
+            name = FileNameHandler().completePath(path, extension);
+        } else if (extension.isEmpty()) {
+            name += "png";
+        }
+        formats << saveFormat(name);
+    }
+    if (tasks & CR::COPY) {
+        formats << clipboardFormat();
+        if (config.saveAfterCopy() && !config.savePath().isEmpty()) {
+            formats << saveFormat(
+              FileNameHandler().completePath(config.savePath(), extension));
+        }
+    }
+    if (tasks & CR::UPLOAD) {
+        formats << (config.indexedPngForUpload() ? "png8" : "png");
+    }
+    encoded.setSinkFormats(formats);
 
-        file.write(byteArray);
+    if (tasks & CR::PRINT_RAW) {
+        // Text printed through the C stream, e.g. the geometry, goes first
+        fflush(stdout);
+        QFile file;
+        file.open(
+          fileno(stdout), QIODevice::WriteOnly, QFileDevice::DontCloseHandle);
+        // Streamed to stdout while it is being encoded, and cached if other
+        // tasks need the same format
+        if (!encoded.write(&file, req.rawFormat())) {
+            AbstractLogger::error()
+              << tr("Error while printing the capture") + ": " +
+                   encoded.errorString();
+        }
         file.close();
     }
 
     if (tasks & CR::SAVE) {
         if (req.path().isEmpty()) {
-            saveToFilesystemGUI(capture);
+            saveToFilesystemGUI(encoded);
         } else {
-            saveToFilesystem(capture, path);
+            saveToFilesystem(encoded, path);
         }
     }
 
     if (tasks & CR::COPY) {
-        FlameshotDaemon::copyToClipboard(capture);
+        FlameshotDaemon::copyToClipboard(encoded);
     }
 
     if (tasks & CR::PIN) {
@@ -399,7 +463,7 @@ void Flameshot::exportCapture(const QPixmap& capture,
             }
         }
 
-        ImgUploaderBase* widget = ImgUploaderManager().uploader(capture);
+        ImgUploaderBase* widget = ImgUploaderManager().uploader(encoded);
         widget->show();
         widget->activateWindow();
         // NOTE: lambda can't capture 'this' because it might be destroyed later
@@ -6,12 +6,14 @@
 #include "pinwidget.h"
 #include "screenshotsaver.h"
 #include "src/utils/globalvalues.h"
+#include "src/utils/sharedimage.h"
 #include "src/widgets/capture/capturewidget.h"
 #include "src/widgets/trayicon.h"
 #include <QApplication>
 #include <QClipboard>
 #include <QDBusConnection>
 #include <QDBusMessage>
+#include <QDBusUnixFileDescriptor>
 #include <QPixmap>
 #include <QRect>
 
@@ -29,6 +31,10 @@
 #include "src/core/globalshortcutfilter.h"
 #endif
 
+#ifdef USE_PORTAL_SCREENCAST
+#include "src/utils/portalscreencast.h"
+#endif
+
 /**
  * @brief A way of accessing the flameshot daemon both from the daemon itself,
  * and from subcommands.
@@ -38,7 +44,9 @@
  * - Listen for hotkey events that will trigger captures,
  * - Host pinned screenshot widgets,
  * - Host the clipboard on X11, where the clipboard gets lost once flameshot
- *   quits.
+ *   quits,
+ * - Host the portal screen cast session, if enabled, so that the permission
+ *   to capture the screen is only asked once.
  *
  * If the `autoCloseIdleDaemon` option is true, the daemon will close as soon as
  * it is not needed to host pinned screenshots and the clipboard. On Windows,
@@ -113,6 +121,20 @@ void FlameshotDaemon::createPin(const QPixmap& capture, QRect geometry)
         return;
     }
 
+    if (canPassFileDescriptors()) {
+        int stride = 0;
+        QImage image = capture.toImage();
+        QDBusUnixFileDescriptor fd = SharedImage::write(image, stride);
+        if (fd.isValid()) {
+            QDBusMessage m = createMethodCall(QStringLiteral("attachPinFd"));
+            m << QVariant::fromValue(fd) << image.width() << image.height()
+              << stride << capture.devicePixelRatio() << geometry;
+            call(m);
+            return;
+        }
+    }
+
+    // Fall back to serializing the pixmap, which encodes it as PNG
     QByteArray data;
     QDataStream stream(&data, QIODevice::WriteOnly);
     stream << capture;
@@ -122,19 +144,33 @@ void FlameshotDaemon::createPin(const QPixmap& capture, QRect geometry)
     call(m);
 }
 
-void FlameshotDaemon::copyToClipboard(const QPixmap& capture)
+void FlameshotDaemon::copyToClipboard(const EncodedCapture& capture)
 {
     if (instance()) {
         instance()->attachScreenshotToClipboard(capture);
         return;
     }
 
+    if (canPassFileDescriptors()) {
+        int stride = 0;
+        QImage image = capture.image();
+        QDBusUnixFileDescriptor fd = SharedImage::write(image, stride);
+        if (fd.isValid()) {
+            QDBusMessage m = createMethodCall(
+              QStringLiteral("attachScreenshotToClipboardFd"));
+            m << QVariant::fromValue(fd) << image.width() << image.height()
+              << stride << capture.pixmap().devicePixelRatio();
+            call(m);
+            return;
+        }
+    }
+
     QDBusMessage m =
       createMethodCall(QStringLiteral("attachScreenshotToClipboard"));
 
     QByteArray data;
     QDataStream stream(&data, QIODevice::WriteOnly);
-    stream << capture;
+    stream << capture.pixmap();
 
     m << data;
     call(m);
@@ -156,6 +192,45 @@ void FlameshotDaemon::copyToClipboard(const QString& text,
     sessionBus.call(m);
 }
 
+/**
+ * @brief Capture `region` of the desktop (all of it if null) through the
+ * portal screen cast session of the daemon (see `PortalScreencast`).
+ *
+ * The session is only ever opened in the daemon, other processes get their
+ * capture from it over D-Bus, which starts the daemon if needed.
+ * @return A null image if the capture failed or the session is not available,
+ * in which case the screenshot portal should be used instead
+ */
+QImage FlameshotDaemon::grabScreencast(const QRect& region)
+{
+#ifdef USE_PORTAL_SCREENCAST
+    if (instance()) {
+        return PortalScreencast::instance()->grab(region);
+    }
+    if (!canPassFileDescriptors()) {
+        return {};
+    }
+
+    QDBusMessage m = createMethodCall(QStringLiteral("grabScreencast"));
+    m << region;
+    QDBusConnection sessionBus = QDBusConnection::sessionBus();
+    checkDBusConnection(sessionBus);
+    // The first capture waits for the user to answer the permission dialog
+    QDBusMessage reply = sessionBus.call(m, QDBus::Block, 5 * 60 * 1000);
+    const QList<QVariant> args = reply.arguments();
+    if (reply.type() != QDBusMessage::ReplyMessage || args.size() != 4) {
+        return {};
+    }
+    return SharedImage::read(qdbus_cast<QDBusUnixFileDescriptor>(args[0]),
+                             args[1].toInt(),
+                             args[2].toInt(),
+                             args[3].toInt());
+#else
+    Q_UNUSED(region)
+    return {};
+#endif
+}
+
 /**
  * @brief Is this instance of flameshot hosting any windows as a daemon?
  */
@@ -269,7 +344,8 @@ void FlameshotDaemon::attachPin(const QPixmap& pixmap, QRect geometry)
     pinWidget->activateWindow();
 }
 
-void FlameshotDaemon::attachScreenshotToClipboard(const QPixmap& pixmap)
+void FlameshotDaemon::attachScreenshotToClipboard(
+  const EncodedCapture& capture)
 {
     m_hostingClipboard = true;
     QClipboard* clipboard = QApplication::clipboard();
@@ -277,7 +353,7 @@ void FlameshotDaemon::attachScreenshotToClipboard(const QPixmap& pixmap)
     // This variable is necessary because the signal doesn't get blocked on
     // windows for some reason
     m_clipboardSignalBlocked = true;
-    saveToClipboard(pixmap);
+    saveToClipboard(capture);
     clipboard->blockSignals(false);
 }
 
@@ -304,6 +380,41 @@ void FlameshotDaemon::attachScreenshotToClipboard(const QByteArray& screenshot)
     attachScreenshotToClipboard(p);
 }
 
+void FlameshotDaemon::attachPin(const QDBusUnixFileDescriptor& fd,
+                                int width,
+                                int height,
+                                int stride,
+                                qreal devicePixelRatio,
+                                QRect geometry)
+{
+    QImage image = SharedImage::read(fd, width, height, stride);
+    if (image.isNull()) {
+        AbstractLogger::error() << tr("Unable to read the shared screenshot");
+        return;
+    }
+    // The pin widget draws a pixmap, the only copy made of the mapping
+    image.setDevicePixelRatio(devicePixelRatio);
+    attachPin(QPixmap::fromImage(image), geometry);
+}
+
+void FlameshotDaemon::attachScreenshotToClipboard(
+  const QDBusUnixFileDescriptor& fd,
+  int width,
+  int height,
+  int stride,
+  qreal devicePixelRatio)
+{
+    QImage image = SharedImage::read(fd, width, height, stride);
+    if (image.isNull()) {
+        AbstractLogger::error() << tr("Unable to read the shared screenshot");
+        return;
+    }
+    // Encoded straight from the mapping, a pixmap is only made if the
+    // clipboard of the platform needs one
+    image.setDevicePixelRatio(devicePixelRatio);
+    attachScreenshotToClipboard(EncodedCapture(image));
+}
+
 void FlameshotDaemon::attachTextToClipboard(const QString& text,
                                             const QString& notification)
 {
@@ -420,5 +531,18 @@ void FlameshotDaemon::call(const QDBusMessage& m)
     sessionBus.call(m);
 }
 
+/**
+ * @brief Can screenshots be passed to the daemon as a file descriptor?
+ */
+bool FlameshotDaemon::canPassFileDescriptors()
+{
+#if defined(Q_OS_LINUX)
+    return QDBusConnection::sessionBus().connectionCapabilities().testFlag(
+      QDBusConnection::UnixFileDescriptorPassing);
+#else
+    return false;
+#endif
+}
+
 // STATIC ATTRIBUTES
 FlameshotDaemon* FlameshotDaemon::m_instance = nullptr;
@@ -4,10 +4,13 @@
 #include <QObject>
 #include <QtDBus/QDBusAbstractAdaptor>
 
+class QImage;
 class QPixmap;
+class EncodedCapture;
 class QRect;
 class QDBusMessage;
 class QDBusConnection;
+class QDBusUnixFileDescriptor;
 class TrayIcon;
 class CaptureWidget;
 
@@ -24,9 +27,10 @@ public:
     static void start();
     static FlameshotDaemon* instance();
     static void createPin(const QPixmap& capture, QRect geometry);
-    static void copyToClipboard(const QPixmap& capture);
+    static void copyToClipboard(const EncodedCapture& capture);
     static void copyToClipboard(const QString& text,
                                 const QString& notification = "");
+    static QImage grabScreencast(const QRect& region = QRect());
     static bool isThisInstanceHostingWidgets();
 
     void sendTrayNotification(
@@ -52,10 +56,21 @@ private:
     FlameshotDaemon();
     void quitIfIdle();
     void attachPin(const QPixmap& pixmap, QRect geometry);
-    void attachScreenshotToClipboard(const QPixmap& pixmap);
+    void attachScreenshotToClipboard(const EncodedCapture& capture);
 
     void attachPin(const QByteArray& data);
     void attachScreenshotToClipboard(const QByteArray& screenshot);
+    void attachPin(const QDBusUnixFileDescriptor& fd,
+                   int width,
+                   int height,
+                   int stride,
+                   qreal devicePixelRatio,
+                   QRect geometry);
+    void attachScreenshotToClipboard(const QDBusUnixFileDescriptor& fd,
+                                     int width,
+                                     int height,
+                                     int stride,
+                                     qreal devicePixelRatio);
     void attachTextToClipboard(const QString& text,
                                const QString& notification);
 
@@ -66,6 +81,7 @@ private:
     static QDBusMessage createMethodCall(const QString& method);
     static void checkDBusConnection(const QDBusConnection& connection);
     static void call(const QDBusMessage& m);
+    static bool canPassFileDescriptors();
 
     bool m_persist;
     bool m_hostingClipboard;
@@ -3,6 +3,8 @@
 
 #include "flameshotdbusadapter.h"
 #include "src/core/flameshotdaemon.h"
+#include "src/utils/sharedimage.h"
+#include <QImage>
 
 FlameshotDBusAdapter::FlameshotDBusAdapter(QObject* parent)
   : QDBusAbstractAdaptor(parent)
@@ -25,3 +27,47 @@ void FlameshotDBusAdapter::attachPin(const QByteArray& data)
 {
     FlameshotDaemon::instance()->attachPin(data);
 }
+
+void FlameshotDBusAdapter::attachScreenshotToClipboardFd(
+  const QDBusUnixFileDescriptor& fd,
+  int width,
+  int height,
+  int stride,
+  double devicePixelRatio)
+{
+    FlameshotDaemon::instance()->attachScreenshotToClipboard(
+      fd, width, height, stride, devicePixelRatio);
+}
+
+void FlameshotDBusAdapter::attachPinFd(const QDBusUnixFileDescriptor& fd,
+                                       int width,
+                                       int height,
+                                       int stride,
+                                       double devicePixelRatio,
+                                       const QRect& geometry)
+{
+    FlameshotDaemon::instance()->attachPin(
+      fd, width, height, stride, devicePixelRatio, geometry);
+}
+
+QDBusUnixFileDescriptor FlameshotDBusAdapter::grabScreencast(
+  const QRect& region,
+  int& width,
+  int& height,
+  int& stride)
+{
+    QImage image = FlameshotDaemon::grabScreencast(region);
+    QDBusUnixFileDescriptor fd;
+    if (!image.isNull()) {
+        fd = SharedImage::write(image, stride);
+    }
+    if (!fd.isValid()) {
+        // An invalid descriptor can't be sent back
+        sendErrorReply(QDBusError::Failed,
+                       QStringLiteral("Unable to grab the screen cast"));
+        return {};
+    }
+    width = image.width();
+    height = image.height();
+    return fd;
+}
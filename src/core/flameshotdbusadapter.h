@@ -3,9 +3,14 @@
 
 #pragma once
 
+#include <QRect>
 #include <QtDBus/QDBusAbstractAdaptor>
+#include <QtDBus/QDBusContext>
+#include <QtDBus/QDBusUnixFileDescriptor>
 
-class FlameshotDBusAdapter : public QDBusAbstractAdaptor
+class FlameshotDBusAdapter
+  : public QDBusAbstractAdaptor
+  , protected QDBusContext
 {
     Q_OBJECT
     Q_CLASSINFO("D-Bus Interface", "org.flameshot.Flameshot")
@@ -19,4 +24,20 @@ public slots:
     Q_NOREPLY void attachTextToClipboard(const QString& text,
                                          const QString& notification);
     Q_NOREPLY void attachPin(const QByteArray& data);
+    Q_NOREPLY void attachScreenshotToClipboardFd(
+      const QDBusUnixFileDescriptor& fd,
+      int width,
+      int height,
+      int stride,
+      double devicePixelRatio);
+    Q_NOREPLY void attachPinFd(const QDBusUnixFileDescriptor& fd,
+                               int width,
+                               int height,
+                               int stride,
+                               double devicePixelRatio,
+                               const QRect& geometry);
+    QDBusUnixFileDescriptor grabScreencast(const QRect& region,
+                                           int& width,
+                                           int& height,
+                                           int& stride);
 };
@@ -24,6 +24,7 @@
 #include <QSharedMemory>
 #include <QTimer>
 #include <QTranslator>
+#include <QtPlugin>
 #if defined(Q_OS_LINUX) || defined(Q_OS_UNIX)
 #include "abstractlogger.h"
 #include "src/core/flameshotdbusadapter.h"
@@ -33,6 +34,9 @@
 #include <desktopinfo.h>
 #endif
 
+// Built-in QOI support for QImageReader and QImageWriter
+Q_IMPORT_PLUGIN(QoiPlugin)
+
 #ifdef Q_OS_LINUX
 // source: https://github.com/ksnip/ksnip/issues/416
 void wayland_hacks()
@@ -235,8 +239,19 @@ int main(int argc, char* argv[])
       { "k", "contrastcolor" },
       QObject::tr("Define the contrast UI color"),
       QStringLiteral("color-code"));
-    CommandOption rawImageOption({ "r", "raw" },
-                                 QObject::tr("Print raw PNG capture"));
+    CommandOption rawImageOption(
+      { "r", "raw" }, QObject::tr("Print raw capture, PNG by default"));
+    CommandOption rawFormatOption(
+      "raw-format",
+      QObject::tr("Format of the raw capture: png, ppm, qoi, rgba, ..."),
+      QStringLiteral("format"),
+      QStringLiteral("png"));
+    CommandOption maxSizeOption(
+      "max-size",
+      QObject::tr("Downscale the exported capture to fit within this size"),
+      QStringLiteral("WxH"));
+    CommandOption trimOption(
+      "trim", QObject::tr("Crop the uniform borders of the exported capture"));
     CommandOption selectionOption(
       { "g", "print-geometry" },
       QObject::tr("Print geometry of the selection in the format WxH+X+Y. Does "
@@ -298,6 +313,21 @@ int main(int argc, char* argv[])
                value == QLatin1String("false");
     };
 
+    const QString rawFormatErr =
+      QObject::tr("Invalid format, it must be rgba or one of the supported "
+                  "image formats");
+    auto rawFormatChecker = [](const QString& format) -> bool {
+        SaveFileExtension valueHandler;
+        return format == QLatin1String("rgba") || valueHandler.check(format);
+    };
+
+    const QString maxSizeErr =
+      QObject::tr("Invalid size, use 'WxH' with positive numbers");
+    auto maxSizeChecker = [](const QString& size) -> bool {
+        MaxSize valueHandler;
+        return !size.isEmpty() && valueHandler.check(size);
+    };
+
     contrastColorOption.addChecker(colorChecker, colorErr);
     mainColorOption.addChecker(colorChecker, colorErr);
     delayOption.addChecker(numericChecker, delayErr);
@@ -308,6 +338,8 @@ int main(int argc, char* argv[])
     autostartOption.addChecker(booleanChecker, booleanErr);
     showHelpOption.addChecker(booleanChecker, booleanErr);
     screenNumberOption.addChecker(numericChecker, numberErr);
+    rawFormatOption.addChecker(rawFormatChecker, rawFormatErr);
+    maxSizeOption.addChecker(maxSizeChecker, maxSizeErr);
 
     // Relationships
     parser.AddArgument(guiArgument);
@@ -323,6 +355,9 @@ int main(int argc, char* argv[])
                         regionOption,
                         useLastRegionOption,
                         rawImageOption,
+                        rawFormatOption,
+                        maxSizeOption,
+                        trimOption,
                         selectionOption,
                         uploadOption,
                         pinOption,
@@ -334,6 +369,9 @@ int main(int argc, char* argv[])
                         delayOption,
                         regionOption,
                         rawImageOption,
+                        rawFormatOption,
+                        maxSizeOption,
+                        trimOption,
                         uploadOption,
                         pinOption },
                       screenArgument);
@@ -342,6 +380,9 @@ int main(int argc, char* argv[])
                         delayOption,
                         regionOption,
                         rawImageOption,
+                        rawFormatOption,
+                        maxSizeOption,
+                        trimOption,
                         uploadOption },
                       fullArgument);
     parser.AddOptions({ autostartOption,
@@ -392,6 +433,9 @@ int main(int argc, char* argv[])
         bool useLastRegion = parser.isSet(useLastRegionOption);
         bool clipboard = parser.isSet(clipboardOption);
         bool raw = parser.isSet(rawImageOption);
+        QString rawFormat = parser.value(rawFormatOption);
+        QString maxSize = parser.value(maxSizeOption);
+        bool trim = parser.isSet(trimOption);
         bool printGeometry = parser.isSet(selectionOption);
         bool pin = parser.isSet(pinOption);
         bool upload = parser.isSet(uploadOption);
@@ -403,11 +447,15 @@ int main(int argc, char* argv[])
         } else if (useLastRegion) {
             req.setInitialSelection(getLastRegion());
         }
+        if (!maxSize.isEmpty()) {
+            req.setMaxSize(MaxSize().value(maxSize).toSize());
+        }
+        req.setTrimBorders(trim);
         if (clipboard) {
             req.addTask(CaptureRequest::COPY);
         }
         if (raw) {
-            req.addTask(CaptureRequest::PRINT_RAW);
+            req.addPrintRawTask(rawFormat);
         }
         if (!path.isEmpty()) {
             req.addSaveTask(path);
@@ -441,6 +489,9 @@ int main(int argc, char* argv[])
         QString region = parser.value(regionOption);
         bool clipboard = parser.isSet(clipboardOption);
         bool raw = parser.isSet(rawImageOption);
+        QString rawFormat = parser.value(rawFormatOption);
+        QString maxSize = parser.value(maxSizeOption);
+        bool trim = parser.isSet(trimOption);
         bool upload = parser.isSet(uploadOption);
         // Not a valid command
 
@@ -448,6 +499,10 @@ int main(int argc, char* argv[])
         if (!region.isEmpty()) {
             req.setInitialSelection(Region().value(region).toRect());
         }
+        if (!maxSize.isEmpty()) {
+            req.setMaxSize(MaxSize().value(maxSize).toSize());
+        }
+        req.setTrimBorders(trim);
         if (clipboard) {
             req.addTask(CaptureRequest::COPY);
         }
@@ -455,7 +510,7 @@ int main(int argc, char* argv[])
             req.addSaveTask(path);
         }
         if (raw) {
-            req.addTask(CaptureRequest::PRINT_RAW);
+            req.addPrintRawTask(rawFormat);
         }
         if (upload) {
             req.addTask(CaptureRequest::UPLOAD);
@@ -479,6 +534,9 @@ int main(int argc, char* argv[])
         QString region = parser.value(regionOption);
         bool clipboard = parser.isSet(clipboardOption);
         bool raw = parser.isSet(rawImageOption);
+        QString rawFormat = parser.value(rawFormatOption);
+        QString maxSize = parser.value(maxSizeOption);
+        bool trim = parser.isSet(trimOption);
         bool pin = parser.isSet(pinOption);
         bool upload = parser.isSet(uploadOption);
 
@@ -493,11 +551,15 @@ int main(int argc, char* argv[])
             }
             req.setInitialSelection(Region().value(region).toRect());
         }
+        if (!maxSize.isEmpty()) {
+            req.setMaxSize(MaxSize().value(maxSize).toSize());
+        }
+        req.setTrimBorders(trim);
         if (clipboard) {
             req.addTask(CaptureRequest::COPY);
         }
         if (raw) {
-            req.addTask(CaptureRequest::PRINT_RAW);
+            req.addPrintRawTask(rawFormat);
         }
         if (!path.isEmpty()) {
             req.addSaveTask(path);
@@ -2,8 +2,17 @@
 // SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
 
 #include "abstractpathtool.h"
+#include <QtMath>
 #include <cmath>
 
+namespace {
+
+// Room left around the path, in device pixels, when the bitmap of a stroke
+// grows, so that it isn't reallocated for every new point
+const int strokeGrowth = 256;
+
+} // namespace
+
 AbstractPathTool::AbstractPathTool(QObject* parent)
   : CaptureTool(parent)
   , m_thickness(1)
@@ -84,9 +93,113 @@ QRect AbstractPathTool::boundingRect() const
       .normalized();
 }
 
+bool AbstractPathTool::hitTest(const QPoint& pos, int radius) const
+{
+    const qreal reach = radius + m_thickness / 2.0;
+    if (m_points.size() == 1) {
+        return QLineF(m_points.first(), pos).length() <= reach;
+    }
+    for (int i = 1; i < m_points.size(); ++i) {
+        if (distanceToSegment(pos, m_points[i - 1], m_points[i]) <= reach) {
+            return true;
+        }
+    }
+    return false;
+}
+
+qint64 AbstractPathTool::memoryUsage() const
+{
+    return CaptureTool::memoryUsage() + m_points.size() * sizeof(QPoint);
+}
+
+/**
+ * @brief Draw the path being drawn, only adding the segments of the points
+ * added since the previous call to the stroke drawn so far. The whole path
+ * is drawn again when its pen changes or its bitmap grows, and by `process`
+ * once it is done.
+ *
+ * The bitmap only covers the path and grows ahead of it by at least half
+ * its size, so it is reallocated a few times per stroke rather than covering
+ * the whole capture.
+ */
+void AbstractPathTool::drawPreview(QPainter& painter, const QPixmap& pixmap)
+{
+    // The stroke is drawn opaque and blended with the alpha of the color as
+    // a whole, the overlapping ends of its segments would be darker else
+    QPen strokePen = pen();
+    QColor color = strokePen.color();
+    color.setAlpha(255);
+    strokePen.setColor(color);
+
+    const qreal ratio = pixmap.devicePixelRatio();
+    if (m_strokePen != strokePen ||
+        (!m_stroke.isNull() && m_stroke.devicePixelRatio() != ratio)) {
+        m_stroke = QPixmap();
+        m_strokeRect = QRect();
+        m_strokePen = strokePen;
+        m_strokeSize = 0;
+    }
+    if (m_strokeSize < m_points.size()) {
+        // Start from the last point drawn so the new segments join it
+        int first = qMax(0, m_strokeSize - 1);
+        QRect needed = strokeArea(first, strokePen.widthF(), ratio)
+                         .intersected(pixmap.rect());
+        if (!needed.isEmpty() && !m_strokeRect.contains(needed)) {
+            int margin = qMax(
+              strokeGrowth,
+              qMax(m_strokeRect.width(), m_strokeRect.height()) / 2);
+            m_strokeRect = m_strokeRect.united(needed)
+                             .adjusted(-margin, -margin, margin, margin)
+                             .intersected(pixmap.rect());
+            m_stroke = QPixmap(m_strokeRect.size());
+            m_stroke.setDevicePixelRatio(ratio);
+            m_stroke.fill(Qt::transparent);
+            first = 0;
+        }
+        if (!m_stroke.isNull()) {
+            QPainter strokePainter(&m_stroke);
+            strokePainter.setRenderHints(painter.renderHints());
+            strokePainter.translate(-QPointF(m_strokeRect.topLeft()) / ratio);
+            strokePainter.setPen(strokePen);
+            strokePainter.drawPolyline(m_points.constData() + first,
+                                       m_points.size() - first);
+        }
+        m_strokeSize = m_points.size();
+    }
+    if (m_stroke.isNull()) {
+        return;
+    }
+
+    qreal opacity = painter.opacity();
+    painter.setOpacity(opacity * pen().color().alphaF());
+    // At a whole device pixel, so that the bitmap isn't resampled
+    painter.drawPixmap(QPointF(m_strokeRect.topLeft()) / ratio, m_stroke);
+    painter.setOpacity(opacity);
+}
+
+/**
+ * @brief The device pixels covered by the path from the point `first` on,
+ * drawn with a pen of `width`, at the device pixel `ratio`.
+ */
+QRect AbstractPathTool::strokeArea(int first, qreal width, qreal ratio) const
+{
+    QRect points(m_points[first], m_points[first]);
+    for (int i = first + 1; i < m_points.size(); ++i) {
+        points |= QRect(m_points[i], m_points[i]);
+    }
+    // Square caps reach half the width diagonally, plus antialiasing
+    int pad = qCeil(width * M_SQRT1_2) + 2;
+    QRectF area = QRectF(points).adjusted(-pad, -pad, pad + 1, pad + 1);
+    return QRectF(area.topLeft() * ratio, area.bottomRight() * ratio)
+      .toAlignedRect();
+}
+
 void AbstractPathTool::drawEnd(const QPoint& p)
 {
     Q_UNUSED(p)
+    m_stroke = QPixmap();
+    m_strokeRect = QRect();
+    m_strokeSize = 0;
 }
 
 void AbstractPathTool::drawMove(const QPoint& p)
@@ -104,6 +217,11 @@ void AbstractPathTool::onSizeChanged(int size)
     m_thickness = size;
 }
 
+QPen AbstractPathTool::pen() const
+{
+    return QPen(m_color, m_thickness);
+}
+
 void AbstractPathTool::addPoint(const QPoint& point)
 {
     if (m_pathArea.left() > point.x()) {
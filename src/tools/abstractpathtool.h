@@ -17,6 +17,9 @@ public:
     bool showMousePreview() const override;
     QRect mousePreviewRect(const CaptureContext& context) const override;
     QRect boundingRect() const override;
+    bool hitTest(const QPoint& pos, int radius) const override;
+    qint64 memoryUsage() const override;
+    void drawPreview(QPainter& painter, const QPixmap& pixmap) override;
     void move(const QPoint& mousePos) override;
     const QPoint* pos() override;
     int size() const override { return m_thickness; };
@@ -30,6 +33,7 @@ public slots:
 protected:
     void copyParams(const AbstractPathTool* from, AbstractPathTool* to);
     void addPoint(const QPoint& point);
+    virtual QPen pen() const;
 
     // class members
     QRect m_pathArea;
@@ -40,5 +44,15 @@ protected:
     QPoint m_pos;
 
 private:
+    QRect strokeArea(int first, qreal width, qreal ratio) const;
+
     int m_thickness;
+    // The path drawn so far while it is being drawn, with m_strokePen made
+    // opaque, and the number of points drawn in it. The bitmap only covers
+    // m_strokeRect, in device pixels of the capture, which grows with the
+    // path.
+    QPixmap m_stroke;
+    QRect m_strokeRect;
+    QPen m_strokePen;
+    int m_strokeSize = 0;
 };
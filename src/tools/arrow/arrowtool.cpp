@@ -155,6 +155,13 @@ void ArrowTool::process(QPainter& painter, const QPixmap& pixmap)
     painter.fillPath(m_arrowPath, QBrush(color()));
 }
 
+bool ArrowTool::hitTest(const QPoint& pos, int radius) const
+{
+    return distanceToSegment(pos, points().first, points().second) <=
+             radius + size() / 2.0 ||
+           getArrowHead(points().first, points().second, size()).contains(pos);
+}
+
 void ArrowTool::pressed(CaptureContext& context)
 {
     Q_UNUSED(context)
@@ -8,6 +8,7 @@
 #include "src/utils/pathinfo.h"
 #include <QIcon>
 #include <QPainter>
+#include <cmath>
 
 class CaptureTool : public QObject
 {
@@ -97,6 +98,8 @@ public:
     virtual bool isSelectable() const = 0;
     // Enable mouse preview.
     virtual bool showMousePreview() const = 0;
+    // If process() reads the pixmap under the tool, e.g. to blur it.
+    virtual bool readsPixmap() const { return false; }
     virtual QRect mousePreviewRect(const CaptureContext& context) const
     {
         return {};
@@ -126,6 +129,9 @@ public:
     virtual QWidget* configurationWidget() { return nullptr; }
     // Return a copy of the tool
     virtual CaptureTool* copy(QObject* parent = nullptr) = 0;
+    // Approximate memory held by the object in bytes, for the undo budget.
+    // Tools holding variable size data should add it.
+    virtual qint64 memoryUsage() const { return 512; }
 
     virtual void setEditMode(bool b) { m_editMode = b; };
     virtual bool editMode() { return m_editMode; };
@@ -144,6 +150,19 @@ public:
     {
         process(painter, pixmap);
     };
+    // Called every time the object being drawn with the mouse has to be
+    // painted, tools can reuse what they drew for the previous call
+    virtual void drawPreview(QPainter& painter, const QPixmap& pixmap)
+    {
+        process(painter, pixmap);
+    };
+    // If the object is drawn within `radius` pixels of `pos`, to select it
+    // with the mouse. Defaults to its bounding rect.
+    virtual bool hitTest(const QPoint& pos, int radius) const
+    {
+        return (boundingRect() + QMargins(radius, radius, radius, radius))
+          .contains(pos);
+    }
     virtual void drawObjectSelection(QPainter& painter)
     {
         drawObjectSelectionRect(painter, boundingRect());
@@ -171,6 +190,17 @@ protected:
                                           : PathInfo::blackIconPath();
     }
 
+    static qreal distanceToSegment(const QPointF& p,
+                                   const QPointF& a,
+                                   const QPointF& b)
+    {
+        QPointF ab = b - a;
+        qreal length = QPointF::dotProduct(ab, ab);
+        qreal t = length > 0 ? QPointF::dotProduct(p - a, ab) / length : 0;
+        QPointF d = p - (a + qBound(0.0, t, 1.0) * ab);
+        return std::sqrt(QPointF::dotProduct(d, d));
+    }
+
     void drawObjectSelectionRect(QPainter& painter, QRect rect)
     {
         QPen orig_pen = painter.pen();
@@ -44,6 +44,27 @@ void CircleTool::process(QPainter& painter, const QPixmap& pixmap)
     painter.drawEllipse(QRect(points().first, points().second));
 }
 
+bool CircleTool::hitTest(const QPoint& pos, int radius) const
+{
+    const qreal reach = radius + size() / 2.0;
+    QRectF rect = QRectF(QRect(points().first, points().second)).normalized();
+    qreal a = rect.width() / 2, b = rect.height() / 2;
+    if (a < 1 || b < 1) {
+        return distanceToSegment(pos, points().first, points().second) <=
+               reach;
+    }
+    // Distance to the outline along the line from the center, which is
+    // exact for circles and close enough for ellipses
+    QPointF d = pos - rect.center();
+    qreal length = std::sqrt(QPointF::dotProduct(d, d));
+    if (length == 0) {
+        return qMin(a, b) <= reach;
+    }
+    qreal dx = d.x() / length, dy = d.y() / length;
+    qreal outline = a * b / std::sqrt(b * b * dx * dx + a * a * dy * dy);
+    return std::abs(length - outline) <= reach;
+}
+
 void CircleTool::pressed(CaptureContext& context)
 {
     Q_UNUSED(context)
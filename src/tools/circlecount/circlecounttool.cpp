@@ -172,6 +172,28 @@ void CircleCountTool::process(QPainter& painter, const QPixmap& pixmap)
     painter.setPen(orig_pen);
 }
 
+bool CircleCountTool::hitTest(const QPoint& pos, int radius) const
+{
+    int bubble_size = size() + THICKNESS_OFFSET;
+    QLineF line(points().first, points().second);
+    if (QLineF(points().first, pos).length() <=
+        bubble_size + PADDING_VALUE + radius) {
+        return true;
+    }
+    if (line.length() <= bubble_size) {
+        return false;
+    }
+    // The pointer, as drawn by process
+    QLineF normal = line.normalVector();
+    normal.setLength(bubble_size);
+    QPointF p1 = normal.p2();
+    QPointF p2 = 2 * QPointF(points().first) - p1;
+    QPolygonF pointer(
+      QVector<QPointF>{ points().first, p1, points().second, p2 });
+    return pointer.containsPoint(pos, Qt::OddEvenFill) ||
+           distanceToSegment(pos, points().first, points().second) <= radius;
+}
+
 void CircleCountTool::paintMousePreview(QPainter& painter,
                                         const CaptureContext& context)
 {
@@ -33,7 +33,7 @@ void ImgUploaderManager::init()
     m_imgUploaderPlugin = "imgur";
 }
 
-ImgUploaderBase* ImgUploaderManager::uploader(const QPixmap& capture,
+ImgUploaderBase* ImgUploaderManager::uploader(const EncodedCapture& capture,
                                               QWidget* parent)
 {
     // TODO - implement ImgUploader for other Storages and selection among them,
@@ -46,7 +46,7 @@ ImgUploaderBase* ImgUploaderManager::uploader(const QPixmap& capture,
     //      (ImgUploaderBase*)(new ImgurUploader(capture, parent));
     //}
     m_imgUploaderBase = (ImgUploaderBase*)(new ImgurUploader(capture, parent));
-    if (m_imgUploaderBase && !capture.isNull()) {
+    if (m_imgUploaderBase && !capture.pixmap().isNull()) {
         m_imgUploaderBase->upload();
     }
     return m_imgUploaderBase;
@@ -19,7 +19,7 @@ class ImgUploaderManager : public QObject
 public:
     explicit ImgUploaderManager(QObject* parent = nullptr);
 
-    ImgUploaderBase* uploader(const QPixmap& capture,
+    ImgUploaderBase* uploader(const EncodedCapture& capture,
                               QWidget* parent = nullptr);
     ImgUploaderBase* uploader(const QString& imgUploaderPlugin);
 
@@ -30,9 +30,10 @@
 #include <QUrlQuery>
 #include <QVBoxLayout>
 
-ImgUploaderBase::ImgUploaderBase(const QPixmap& capture, QWidget* parent)
+ImgUploaderBase::ImgUploaderBase(const EncodedCapture& capture,
+                                 QWidget* parent)
   : QWidget(parent)
-  , m_pixmap(capture)
+  , m_capture(capture)
 {
     setWindowTitle(tr("Upload image"));
     setWindowIcon(QIcon(GlobalValues::iconPath()));
@@ -75,12 +76,21 @@ void ImgUploaderBase::setImageURL(const QUrl& imageURL)
 
 const QPixmap& ImgUploaderBase::pixmap()
 {
-    return m_pixmap;
+    return m_capture.pixmap();
+}
+
+/**
+ * @brief The capture along with the encodings already made while exporting
+ * it.
+ */
+const EncodedCapture& ImgUploaderBase::capture()
+{
+    return m_capture;
 }
 
 void ImgUploaderBase::setPixmap(const QPixmap& pixmap)
 {
-    m_pixmap = pixmap;
+    m_capture = EncodedCapture(pixmap);
 }
 
 NotificationWidget* ImgUploaderBase::notification()
@@ -97,11 +107,11 @@ void ImgUploaderBase::startDrag()
 {
     auto* mimeData = new QMimeData;
     mimeData->setUrls(QList<QUrl>{ m_imageURL });
-    mimeData->setImageData(m_pixmap);
+    mimeData->setImageData(m_capture.pixmap());
 
     auto* dragHandler = new QDrag(this);
     dragHandler->setMimeData(mimeData);
-    dragHandler->setPixmap(m_pixmap.scaled(
+    dragHandler->setPixmap(m_capture.pixmap().scaled(
       256, 256, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation));
     dragHandler->exec();
 }
@@ -114,7 +124,7 @@ void ImgUploaderBase::showPostUploadDialog()
     m_vLayout->addWidget(m_notification);
 
     auto* imageLabel = new ImageLabel();
-    imageLabel->setScreenshot(m_pixmap);
+    imageLabel->setScreenshot(m_capture.pixmap());
     imageLabel->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
     connect(imageLabel,
             &ImageLabel::dragInitiated,
@@ -171,7 +181,7 @@ void ImgUploaderBase::copyURL()
 
 void ImgUploaderBase::copyImage()
 {
-    FlameshotDaemon::copyToClipboard(m_pixmap);
+    FlameshotDaemon::copyToClipboard(m_capture);
     m_notification->showMessage(tr("Screenshot copied to clipboard."));
 }
 
@@ -184,7 +194,7 @@ void ImgUploaderBase::deleteCurrentImage()
 
 void ImgUploaderBase::saveScreenshotToFilesystem()
 {
-    if (!saveToFilesystemGUI(m_pixmap)) {
+    if (!saveToFilesystemGUI(m_capture)) {
         m_notification->showMessage(
           tr("Unable to save the screenshot to disk."));
         return;
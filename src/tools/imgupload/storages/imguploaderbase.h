@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include "src/utils/encodedcapture.h"
 #include <QUrl>
 #include <QWidget>
 
@@ -20,13 +21,15 @@ class ImgUploaderBase : public QWidget
 {
     Q_OBJECT
 public:
-    explicit ImgUploaderBase(const QPixmap& capture, QWidget* parent = nullptr);
+    explicit ImgUploaderBase(const EncodedCapture& capture,
+                             QWidget* parent = nullptr);
 
     LoadSpinner* spinner();
 
     const QUrl& imageURL();
     void setImageURL(const QUrl&);
     const QPixmap& pixmap();
+    const EncodedCapture& capture();
     void setPixmap(const QPixmap&);
     void setInfoLabelText(const QString&);
 
@@ -51,7 +54,7 @@ private slots:
     void saveScreenshotToFilesystem();
 
 private:
-    QPixmap m_pixmap;
+    EncodedCapture m_capture;
 
     QVBoxLayout* m_vLayout;
     QHBoxLayout* m_hLayout;
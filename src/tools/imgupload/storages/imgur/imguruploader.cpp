@@ -2,22 +2,23 @@
 // SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
 
 #include "imguruploader.h"
+#include "src/core/exportqueue.h"
 #include "src/utils/confighandler.h"
 #include "src/utils/filenamehandler.h"
 #include "src/utils/history.h"
 #include "src/widgets/loadspinner.h"
 #include "src/widgets/notificationwidget.h"
-#include <QBuffer>
 #include <QDesktopServices>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QNetworkRequest>
+#include <QPointer>
 #include <QShortcut>
 #include <QUrlQuery>
 
-ImgurUploader::ImgurUploader(const QPixmap& capture, QWidget* parent)
+ImgurUploader::ImgurUploader(const EncodedCapture& capture, QWidget* parent)
   : ImgUploaderBase(capture, parent)
 {
     m_NetworkAM = new QNetworkAccessManager(this);
@@ -61,10 +62,29 @@ void ImgurUploader::handleReply(QNetworkReply* reply)
 
 void ImgurUploader::upload()
 {
-    QByteArray byteArray;
-    QBuffer buffer(&byteArray);
-    pixmap().save(&buffer, "PNG");
+    // Encoded on the export thread, or taken from the formats already
+    // encoded for the other exports of the capture
+    EncodedCapture encoded = capture();
+    encoded.image();
+    QString format = ConfigHandler().indexedPngForUpload() ? "png8" : "png";
+    QPointer<ImgurUploader> self(this);
+    ExportQueue::instance()->enqueue(
+      [encoded, format]() { encoded.data(format); },
+      [self, encoded, format]() {
+          if (self == nullptr) {
+              return;
+          }
+          QByteArray image = encoded.data(format);
+          if (image.isEmpty()) {
+              self->setInfoLabelText(encoded.errorString());
+              return;
+          }
+          self->post(image);
+      });
+}
 
+void ImgurUploader::post(const QByteArray& image)
+{
     QUrlQuery urlQuery;
     urlQuery.addQueryItem(QStringLiteral("title"), QStringLiteral(""));
     QString description = FileNameHandler().parsedPattern();
@@ -80,7 +100,7 @@ void ImgurUploader::upload()
                            .arg(ConfigHandler().uploadClientSecret())
                            .toUtf8());
 
-    m_NetworkAM->post(request, byteArray);
+    m_NetworkAM->post(request, image);
 }
 
 void ImgurUploader::deleteImage(const QString& fileName,
@@ -15,7 +15,8 @@ class ImgurUploader : public ImgUploaderBase
 {
     Q_OBJECT
 public:
-    explicit ImgurUploader(const QPixmap& capture, QWidget* parent = nullptr);
+    explicit ImgurUploader(const EncodedCapture& capture,
+                           QWidget* parent = nullptr);
     void deleteImage(const QString& fileName, const QString& deleteToken);
 
 private slots:
@@ -23,6 +24,7 @@ private slots:
 
 private:
     void upload();
+    void post(const QByteArray& image);
 
 private:
     QNetworkAccessManager* m_NetworkAM;
@@ -46,6 +46,12 @@ void LineTool::process(QPainter& painter, const QPixmap& pixmap)
     painter.drawLine(points().first, points().second);
 }
 
+bool LineTool::hitTest(const QPoint& pos, int radius) const
+{
+    return distanceToSegment(pos, points().first, points().second) <=
+           radius + size() / 2.0;
+}
+
 void LineTool::pressed(CaptureContext& context)
 {
     Q_UNUSED(context)
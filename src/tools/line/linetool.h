@@ -17,6 +17,7 @@ public:
 
     CaptureTool* copy(QObject* parent = nullptr) override;
     void process(QPainter& painter, const QPixmap& pixmap) override;
+    bool hitTest(const QPoint& pos, int radius) const override;
 
 protected:
     CaptureTool::Type type() const override;
@@ -63,6 +63,12 @@ void MarkerTool::process(QPainter& painter, const QPixmap& pixmap)
     painter.setCompositionMode(compositionMode);
 }
 
+bool MarkerTool::hitTest(const QPoint& pos, int radius) const
+{
+    return distanceToSegment(pos, points().first, points().second) <=
+           radius + size() / 2.0;
+}
+
 void MarkerTool::paintMousePreview(QPainter& painter,
                                    const CaptureContext& context)
 {
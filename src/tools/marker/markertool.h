@@ -18,6 +18,7 @@ public:
 
     CaptureTool* copy(QObject* parent = nullptr) override;
     void process(QPainter& painter, const QPixmap& pixmap) override;
+    bool hitTest(const QPoint& pos, int radius) const override;
     void paintMousePreview(QPainter& painter,
                            const CaptureContext& context) override;
 
@@ -38,7 +38,7 @@ CaptureTool* PencilTool::copy(QObject* parent)
 void PencilTool::process(QPainter& painter, const QPixmap& pixmap)
 {
     Q_UNUSED(pixmap)
-    painter.setPen(QPen(m_color, size()));
+    painter.setPen(pen());
     painter.drawPolyline(m_points.data(), m_points.size());
 }
 
@@ -15,6 +15,7 @@ public:
     QString name() const override;
     QString description() const override;
     QRect boundingRect() const override;
+    bool readsPixmap() const override { return true; }
 
     CaptureTool* copy(QObject* parent = nullptr) override;
     void process(QPainter& painter, const QPixmap& pixmap) override;
@@ -50,6 +50,18 @@ void SelectionTool::process(QPainter& painter, const QPixmap& pixmap)
     painter.drawRect(QRect(points().first, points().second));
 }
 
+bool SelectionTool::hitTest(const QPoint& pos, int radius) const
+{
+    // Only the outline is drawn
+    QPointF a = points().first, c = points().second;
+    QPointF b(c.x(), a.y()), d(a.x(), c.y());
+    qreal distance = qMin(qMin(distanceToSegment(pos, a, b),
+                               distanceToSegment(pos, b, c)),
+                          qMin(distanceToSegment(pos, c, d),
+                               distanceToSegment(pos, d, a)));
+    return distance <= radius + size() / 2.0;
+}
+
 void SelectionTool::pressed(CaptureContext& context)
 {
     Q_UNUSED(context)
@@ -193,6 +193,12 @@ CaptureTool* TextTool::copy(QObject* parent)
     return textTool;
 }
 
+qint64 TextTool::memoryUsage() const
+{
+    return CaptureTool::memoryUsage() +
+           (m_text.size() + m_textOld.size()) * sizeof(QChar);
+}
+
 void TextTool::process(QPainter& painter, const QPixmap& pixmap)
 {
     Q_UNUSED(pixmap)
@@ -32,6 +32,7 @@ public:
     QWidget* widget() override;
     QWidget* configurationWidget() override;
     CaptureTool* copy(QObject* parent = nullptr) override;
+    qint64 memoryUsage() const override;
 
     void process(QPainter& painter, const QPixmap& pixmap) override;
     void paintMousePreview(QPainter& painter,
@@ -0,0 +1,247 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "atomicfilesaver.h"
+#include "src/core/exportqueue.h"
+#include "src/utils/filenamehandler.h"
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QList>
+#include <QLoggingCategory>
+#include <QSharedPointer>
+
+#ifdef Q_OS_UNIX
+#include <QSet>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#else
+#include <QTemporaryFile>
+#endif
+
+Q_LOGGING_CATEGORY(lcSave, "flameshot.save", QtInfoMsg)
+
+namespace {
+
+// Bounds how long a file can stay pending during a long burst
+const int maxBatchSize = 16;
+
+struct PendingFile
+{
+    QString path;
+    QString format;
+    QString tempPath;
+    QElapsedTimer timer;
+    AtomicFileSaver::Callback done;
+    AtomicFileSaver::Result result;
+};
+
+using Batch = QList<PendingFile>;
+
+// Saves that have been queued but not written yet
+QAtomicInt queuedSaves;
+
+#ifdef Q_OS_UNIX
+// Written but not committed yet, only used from the export thread
+Batch pendingFiles;
+
+QString errnoString()
+{
+    return QString::fromLocal8Bit(strerror(errno));
+}
+
+/**
+ * @brief Create a temporary file next to `path`.
+ *
+ * Unlike `QTemporaryFile`, the file is created with the default permissions
+ * (0666 minus the umask), which it keeps once moved.
+ */
+int createTemporary(const QString& path, QString& tempPath)
+{
+    static QAtomicInt counter;
+    QFileInfo info(path);
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        tempPath = QStringLiteral("%1/.%2.%3-%4.tmp")
+                     .arg(info.absolutePath(), info.fileName())
+                     .arg(getpid())
+                     .arg(counter.fetchAndAddRelaxed(1));
+        int fd = ::open(QFile::encodeName(tempPath).constData(),
+                        O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC,
+                        0666);
+        if (fd != -1) {
+            return fd;
+        }
+        if (errno != EEXIST) {
+            break;
+        }
+    }
+    // Not ours, don't let it be removed
+    tempPath.clear();
+    return -1;
+}
+
+void writeTemporary(PendingFile& file, const EncodedCapture& capture)
+{
+    int fd = createTemporary(file.path, file.tempPath);
+    if (fd == -1) {
+        file.result.error = errnoString();
+        return;
+    }
+
+    QFile out;
+    out.open(fd, QIODevice::WriteOnly, QFileDevice::AutoCloseHandle);
+    bool ok = capture.write(&out, file.format);
+    ok = out.flush() && ok;
+    if (out.error() != QFile::NoError) {
+        file.result.error = out.errorString();
+    } else if (!ok) {
+        file.result.error = capture.errorString();
+    }
+    out.close();
+    file.result.ok = ok;
+}
+
+/**
+ * @brief Sync `path` (a file or a directory) to disk, only its data and the
+ * metadata needed to read it back if `dataOnly`.
+ */
+bool syncPath(const QString& path, bool dataOnly = false)
+{
+    int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return false;
+    }
+#ifdef Q_OS_LINUX
+    bool ok = (dataOnly ? fdatasync(fd) : fsync(fd)) == 0;
+#else
+    Q_UNUSED(dataOnly)
+    bool ok = fsync(fd) == 0;
+#endif
+    ::close(fd);
+    return ok;
+}
+
+/**
+ * @brief Sync the content of the written files of `batch` to disk.
+ *
+ * Each file is synced on its own rather than with a syncfs(), which would
+ * also wait for the unrelated writeback of the file system.
+ */
+void syncData(Batch& batch)
+{
+    for (PendingFile& file : batch) {
+        if (file.result.ok && !syncPath(file.tempPath, true)) {
+            file.result = { false, errnoString() };
+        }
+    }
+}
+
+/**
+ * @brief Move every pending file into place and hand them to `committed`.
+ */
+void commitPending(Batch& committed)
+{
+    Batch batch;
+    batch.swap(pendingFiles);
+    syncData(batch);
+
+    QSet<QString> directories;
+    for (PendingFile& file : batch) {
+        if (file.result.ok) {
+            file.result.path =
+              FileNameHandler::claimScreenshotPath(file.tempPath, file.path);
+            if (file.result.path.isEmpty()) {
+                file.result = { false, errnoString() };
+            }
+        }
+        if (file.result.ok) {
+            directories.insert(QFileInfo(file.result.path).absolutePath());
+        } else if (!file.tempPath.isEmpty()) {
+            ::unlink(QFile::encodeName(file.tempPath).constData());
+        }
+    }
+    // Makes the moves durable, the files are complete either way
+    for (const QString& directory : qAsConst(directories)) {
+        syncPath(directory);
+    }
+
+    for (PendingFile& file : batch) {
+        file.result.latency = file.timer.elapsed();
+        qCDebug(lcSave) << file.result.path << "saved in" << file.result.latency
+                        << "ms, batch of" << batch.size();
+    }
+    committed.append(batch);
+}
+#endif
+
+} // namespace
+
+/**
+ * @brief Queue saving `capture` to `path`, encoded in `format` (see
+ * `EncodedCapture::data`).
+ *
+ * @param path Complete path of the file (see `FileNameHandler::completePath`),
+ * a "_NUM" suffix is added if it exists when the file is moved into place
+ * @param capture Used from the export thread, its `image()` must have been
+ * called on the GUI thread
+ * @param done Called on the GUI thread once the file is in place or saving
+ * it failed
+ */
+void AtomicFileSaver::save(const EncodedCapture& capture,
+                           const QString& path,
+                           const QString& format,
+                           const Callback& done)
+{
+    PendingFile file;
+    file.path = path;
+    file.format = format;
+    file.done = done;
+    file.timer.start();
+    // Files committed by the job, which may include earlier ones
+    auto committed = QSharedPointer<Batch>::create();
+
+    queuedSaves.ref();
+    ExportQueue::instance()->enqueue(
+      [capture, file, committed]() mutable {
+#ifdef Q_OS_UNIX
+          writeTemporary(file, capture);
+          pendingFiles.append(file);
+          // The saves queued meanwhile are committed along with this one
+          if (!queuedSaves.deref() || pendingFiles.size() >= maxBatchSize) {
+              commitPending(*committed);
+          }
+#else
+          queuedSaves.deref();
+          QTemporaryFile out(QFileInfo(file.path).absolutePath() +
+                             QStringLiteral("/.flameshot-XXXXXX.tmp"));
+          if (!out.open()) {
+              file.result.error = out.errorString();
+          } else if (!capture.write(&out, file.format)) {
+              file.result.error = capture.errorString();
+          } else if (!out.flush()) {
+              file.result.error = out.errorString();
+          } else {
+              out.close();
+              file.result.path = FileNameHandler::claimScreenshotPath(
+                out.fileName(), file.path);
+              file.result.ok = !file.result.path.isEmpty();
+              if (file.result.ok) {
+                  // Moved, nothing left to remove
+                  out.setAutoRemove(false);
+              } else {
+                  file.result.error = QObject::tr("Unable to move the file");
+              }
+          }
+          file.result.latency = file.timer.elapsed();
+          committed->append(file);
+#endif
+      },
+      [committed]() {
+          for (const PendingFile& file : qAsConst(*committed)) {
+              file.done(file.result);
+          }
+      });
+}
@@ -0,0 +1,48 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include "src/utils/encodedcapture.h"
+#include <QString>
+#include <functional>
+
+/**
+ * @brief Writes captures to disk atomically from the `ExportQueue`, syncing
+ * bursts of files together.
+ *
+ * Each capture is encoded into a temporary file next to its destination,
+ * which is only moved into place once its content has reached the disk, so
+ * a crash never leaves a truncated image behind. The destination name is
+ * only taken at that point, with a "_NUM" suffix if it exists by then (see
+ * `FileNameHandler::claimScreenshotPath`), so nothing shows up in the
+ * directory while the file is pending and no existing file is replaced.
+ *
+ * Syncing is what makes a save slow, so files are not committed one by one:
+ * as long as more saves are waiting in the queue, written files are kept
+ * pending and the whole batch is then committed at once (a data sync of each
+ * file, the moves, one sync per directory). A burst of captures therefore
+ * shares the directory syncs, and since all of it runs on the export thread
+ * it never delays the next grab.
+ *
+ * The time from `save()` to the file being in place is reported through the
+ * `flameshot.save` logging category, e.g. with
+ * `QT_LOGGING_RULES="flameshot.save.debug=true"`.
+ */
+class AtomicFileSaver
+{
+public:
+    struct Result
+    {
+        bool ok = false;
+        QString error;
+        QString path; // where the file was saved
+        qint64 latency = 0; // milliseconds
+    };
+    using Callback = std::function<void(const Result&)>;
+
+    static void save(const EncodedCapture& capture,
+                     const QString& path,
+                     const QString& format,
+                     const Callback& done);
+};
@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "bordertrimmer.h"
+
+namespace {
+
+// Pixels compared at once before checking for a difference
+const int blockSize = 16;
+
+/**
+ * @brief Index of the first pixel of `line` that is not `color`, or `size`.
+ */
+int firstDifferent(const QRgb* line, int size, QRgb color)
+{
+    int i = 0;
+    for (; i + blockSize <= size; i += blockSize) {
+        QRgb diff = 0;
+        for (int k = 0; k < blockSize; ++k) {
+            diff |= line[i + k] ^ color;
+        }
+        if (diff != 0) {
+            break;
+        }
+    }
+    while (i < size && line[i] == color) {
+        ++i;
+    }
+    return i;
+}
+
+/**
+ * @brief Index of the last pixel of `line` that is not `color`, or -1.
+ */
+int lastDifferent(const QRgb* line, int size, QRgb color)
+{
+    int i = size;
+    for (; i - blockSize >= 0; i -= blockSize) {
+        QRgb diff = 0;
+        for (int k = 1; k <= blockSize; ++k) {
+            diff |= line[i - k] ^ color;
+        }
+        if (diff != 0) {
+            break;
+        }
+    }
+    while (i > 0 && line[i - 1] == color) {
+        --i;
+    }
+    return i - 1;
+}
+
+inline const QRgb* line(const QImage& image, int y)
+{
+    return reinterpret_cast<const QRgb*>(image.constScanLine(y));
+}
+
+} // namespace
+
+namespace BorderTrimmer {
+
+/**
+ * @brief The part of `image` inside its uniform borders.
+ * @return The whole image if it is uniform
+ */
+QRect contentRect(const QImage& image)
+{
+    if (image.isNull()) {
+        return {};
+    }
+    const QImage source = image.convertToFormat(
+      image.hasAlphaChannel() ? QImage::Format_ARGB32 : QImage::Format_RGB32);
+    const int width = source.width();
+    const QRgb color = line(source, 0)[0];
+
+    int top = 0;
+    while (top < source.height() &&
+           firstDifferent(line(source, top), width, color) == width) {
+        ++top;
+    }
+    if (top == source.height()) {
+        return image.rect();
+    }
+    int bottom = source.height() - 1;
+    while (firstDifferent(line(source, bottom), width, color) == width) {
+        --bottom;
+    }
+
+    // Each row only needs to be read up to the current bounds
+    int left = width, right = -1;
+    for (int y = top; y <= bottom; ++y) {
+        const QRgb* pixels = line(source, y);
+        left = qMin(left, firstDifferent(pixels, left, color));
+        int last = lastDifferent(pixels + right + 1, width - right - 1, color);
+        if (last >= 0) {
+            right += last + 1;
+        }
+    }
+    return QRect(QPoint(left, top), QPoint(right, bottom));
+}
+
+/**
+ * @brief `image` cropped to `contentRect`.
+ */
+QImage trimmed(const QImage& image)
+{
+    QRect rect = contentRect(image);
+    if (rect == image.rect()) {
+        return image;
+    }
+    return image.copy(rect);
+}
+
+} // namespace
@@ -0,0 +1,25 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include <QImage>
+#include <QRect>
+
+/**
+ * @brief Removal of the uniform borders of captures, e.g. a band of solid
+ * background around a selection.
+ *
+ * The border color is the one of the top left pixel. Rows are compared with
+ * it from the top and the bottom, then each remaining row from both ends,
+ * until a different pixel is found, so only the border and a few pixels
+ * past it are ever read. The comparisons are done a block of pixels at a
+ * time, which the compiler vectorizes.
+ */
+namespace BorderTrimmer { // namespace
+
+QRect contentRect(const QImage& image);
+
+QImage trimmed(const QImage& image);
+
+} // namespace
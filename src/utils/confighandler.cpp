@@ -94,6 +94,10 @@ static QMap<class QString, QSharedPointer<ValueHandler>>
     OPTION("copyPathAfterSave"           ,Bool               ( false         )),
     OPTION("antialiasingPinZoom"         ,Bool               ( true          )),
     OPTION("useJpgForClipboard"          ,Bool               ( false         )),
+    OPTION("indexedPngForSave"           ,Bool               ( false         )),
+    OPTION("indexedPngForClipboard"      ,Bool               ( false         )),
+    OPTION("indexedPngForUpload"         ,Bool               ( false         )),
+    OPTION("webpLossless"                ,Bool               ( false         )),
     OPTION("uploadWithoutConfirmation"   ,Bool               ( false         )),
     OPTION("saveAfterCopy"               ,Bool               ( false         )),
     OPTION("savePath"                    ,ExistingDir        (                   )),
@@ -102,6 +106,7 @@ static QMap<class QString, QSharedPointer<ValueHandler>>
     OPTION("saveLastRegion"              ,Bool               (false          )),
     OPTION("uploadHistoryMax"            ,LowerBoundedInt    (0, 25               )),
     OPTION("undoLimit"                   ,BoundedInt         (0, 999, 100    )),
+    OPTION("undoMemoryLimit"             ,BoundedInt         (0, 4096, 64    )),
   // Interface tab
     OPTION("uiColor"                     ,Color              ( {116, 0, 150}   )),
     OPTION("contrastUiColor"             ,Color              ( {39, 0, 50}     )),
@@ -125,7 +130,11 @@ static QMap<class QString, QSharedPointer<ValueHandler>>
     OPTION("uploadClientSecret"          ,String             ( "313baf0c7b4d3ff"            )),
     OPTION("showSelectionGeometry"  , BoundedInt               (0,5,4)),
     OPTION("showSelectionGeometryHideTime", LowerBoundedInt       (0, 3000)),
-    OPTION("jpegQuality", BoundedInt     (0,100,75))
+    OPTION("jpegQuality", BoundedInt     (0,100,75)),
+    OPTION("pngCompressionLevel", BoundedInt (0,9,6)),
+    OPTION("pngFilter"                   ,PngFilter          (                )),
+    OPTION("exportMaxSize"               ,MaxSize            (                )),
+    OPTION("trimBorders"                 ,Bool               ( false         ))
 };
 
 static QMap<QString, QSharedPointer<KeySequence>> recognizedShortcuts = {
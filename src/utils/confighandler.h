@@ -5,6 +5,7 @@
 
 #include "src/widgets/capture/capturetoolbutton.h"
 #include <QSettings>
+#include <QSize>
 #include <QStringList>
 #include <QVariant>
 #include <QVector>
@@ -112,6 +113,12 @@ public:
     CONFIG_GETTER_SETTER(saveAsFileExtension, setSaveAsFileExtension, QString)
     CONFIG_GETTER_SETTER(antialiasingPinZoom, setAntialiasingPinZoom, bool)
     CONFIG_GETTER_SETTER(useJpgForClipboard, setUseJpgForClipboard, bool)
+    CONFIG_GETTER_SETTER(indexedPngForSave, setIndexedPngForSave, bool)
+    CONFIG_GETTER_SETTER(indexedPngForClipboard,
+                         setIndexedPngForClipboard,
+                         bool)
+    CONFIG_GETTER_SETTER(indexedPngForUpload, setIndexedPngForUpload, bool)
+    CONFIG_GETTER_SETTER(webpLossless, setWebpLossless, bool)
     CONFIG_GETTER_SETTER(uploadWithoutConfirmation,
                          setUploadWithoutConfirmation,
                          bool)
@@ -119,6 +126,7 @@ public:
                          setIgnoreUpdateToVersion,
                          QString)
     CONFIG_GETTER_SETTER(undoLimit, setUndoLimit, int)
+    CONFIG_GETTER_SETTER(undoMemoryLimit, setUndoMemoryLimit, int)
     CONFIG_GETTER_SETTER(buttons, setButtons, QList<CaptureTool::Type>)
     CONFIG_GETTER_SETTER(showMagnifier, setShowMagnifier, bool)
     CONFIG_GETTER_SETTER(squareMagnifier, setSquareMagnifier, bool)
@@ -127,6 +135,10 @@ public:
     CONFIG_GETTER_SETTER(saveLastRegion, setSaveLastRegion, bool)
     CONFIG_GETTER_SETTER(showSelectionGeometry, setShowSelectionGeometry, int)
     CONFIG_GETTER_SETTER(jpegQuality, setJpegQuality, int)
+    CONFIG_GETTER_SETTER(pngCompressionLevel, setPngCompressionLevel, int)
+    CONFIG_GETTER_SETTER(pngFilter, setPngFilter, QString)
+    CONFIG_GETTER_SETTER(exportMaxSize, setExportMaxSize, QSize)
+    CONFIG_GETTER_SETTER(trimBorders, setTrimBorders, bool)
     CONFIG_GETTER_SETTER(showSelectionGeometryHideTime,
                          showSelectionGeometryHideTime,
                          int)
@@ -0,0 +1,119 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "desktopstitcher.h"
+#include <QRunnable>
+#include <cstring>
+
+namespace {
+
+class BlitTask : public QRunnable
+{
+public:
+    BlitTask(uchar* bits,
+             int bytesPerLine,
+             QImage::Format format,
+             const QImage& capture,
+             const QRect& target,
+             const QRect& clipped)
+      : m_bits(bits)
+      , m_bytesPerLine(bytesPerLine)
+      , m_format(format)
+      , m_capture(capture)
+      , m_target(target)
+      , m_clipped(clipped)
+    {}
+
+    void run() override
+    {
+        QImage source = m_capture;
+        if (source.size() != m_target.size()) {
+            // Outputs with a different device pixel ratio than the desktop
+            source = source.scaled(m_target.size(),
+                                   Qt::IgnoreAspectRatio,
+                                   Qt::SmoothTransformation);
+        }
+        if (source.format() != m_format) {
+            source = source.convertToFormat(m_format);
+        }
+
+        const int pixelBytes = source.depth() / 8;
+        const size_t rowBytes =
+          static_cast<size_t>(m_clipped.width()) * pixelBytes;
+        const QPoint offset = m_clipped.topLeft() - m_target.topLeft();
+        for (int y = 0; y < m_clipped.height(); ++y) {
+            uchar* dst = m_bits + (m_clipped.y() + y) * m_bytesPerLine +
+                         m_clipped.x() * pixelBytes;
+            const uchar* src = source.constScanLine(offset.y() + y) +
+                               offset.x() * pixelBytes;
+            memcpy(dst, src, rowBytes);
+        }
+    }
+
+private:
+    uchar* m_bits;
+    int m_bytesPerLine;
+    QImage::Format m_format;
+    QImage m_capture;
+    QRect m_target;
+    QRect m_clipped;
+};
+
+} // namespace
+
+DesktopStitcher::DesktopStitcher(const QSize& size, QImage::Format format)
+  : m_image(size, format)
+{
+    // Areas not covered by any output stay black
+    m_image.fill(Qt::black);
+}
+
+DesktopStitcher::~DesktopStitcher()
+{
+    m_pool.waitForDone();
+}
+
+/**
+ * @brief Queue the copy of `capture` to the `target` rect of the desktop.
+ *
+ * Targets must not overlap, since the copies run concurrently. Targets of
+ * adjacent outputs at a fractional scale are computed with `scaledRect`.
+ */
+void DesktopStitcher::add(const QImage& capture, const QRect& target)
+{
+    QRect clipped = target.intersected(m_image.rect());
+    if (capture.isNull() || clipped.isEmpty()) {
+        return;
+    }
+    // bits() is called here so that the image is detached before the workers
+    // start writing to it
+    m_pool.start(new BlitTask(m_image.bits(),
+                              m_image.bytesPerLine(),
+                              m_image.format(),
+                              capture,
+                              target,
+                              clipped));
+}
+
+/**
+ * @brief Wait for all queued copies and return the desktop image.
+ */
+QImage DesktopStitcher::result()
+{
+    m_pool.waitForDone();
+    return m_image;
+}
+
+/**
+ * @brief The pixels covered by the logical `rect` at `scale`.
+ *
+ * The edges are rounded rather than the position and the size, so that
+ * adjacent rects share their boundary at fractional scales instead of
+ * overlapping or leaving a gap.
+ */
+QRect DesktopStitcher::scaledRect(const QRect& rect, qreal scale)
+{
+    return QRect(QPoint(qRound(rect.x() * scale), qRound(rect.y() * scale)),
+                 QPoint(qRound((rect.x() + rect.width()) * scale) - 1,
+                        qRound((rect.y() + rect.height()) * scale) - 1));
+}
@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include <QImage>
+#include <QThreadPool>
+
+/**
+ * @brief Assemble the captures of several outputs into one desktop image.
+ *
+ * The desktop image is allocated once up front. Each capture added with
+ * `add` is converted, scaled if needed and copied to its place on a worker
+ * thread, so stitching overlaps with the capture of the remaining outputs.
+ */
+class DesktopStitcher
+{
+public:
+    explicit DesktopStitcher(const QSize& size,
+                             QImage::Format format = QImage::Format_RGB32);
+    ~DesktopStitcher();
+
+    void add(const QImage& capture, const QRect& target);
+    QImage result();
+
+    static QRect scaledRect(const QRect& rect, qreal scale);
+
+private:
+    QImage m_image;
+    QThreadPool m_pool;
+};
@@ -0,0 +1,334 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "encodedcapture.h"
+#include "src/utils/confighandler.h"
+#include "src/utils/palettequantizer.h"
+#include <QBuffer>
+#include <QImageWriter>
+
+#ifdef USE_PARALLEL_PNG
+#include "src/utils/pngencoder.h"
+#endif
+#ifdef USE_PARALLEL_JPEG
+#include "src/utils/jpegencoder.h"
+#endif
+
+namespace {
+
+/**
+ * @brief Writes to `target` and keeps a copy of the data in `copy`.
+ *
+ * The copy is kept even once writing to the target failed, so that the
+ * encoding can still be cached for the other sinks.
+ */
+class TeeDevice : public QIODevice
+{
+public:
+    TeeDevice(QIODevice* target, QByteArray* copy)
+      : m_target(target)
+      , m_copy(copy)
+      , m_targetOk(true)
+    {}
+
+    bool targetOk() const { return m_targetOk; }
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override
+    {
+        Q_UNUSED(data)
+        Q_UNUSED(maxSize)
+        return -1;
+    }
+
+    qint64 writeData(const char* data, qint64 size) override
+    {
+        m_copy->append(data, static_cast<int>(size));
+        if (m_targetOk && m_target->write(data, size) != size) {
+            m_targetOk = false;
+        }
+        return size;
+    }
+
+private:
+    QIODevice* m_target;
+    QByteArray* m_copy;
+    bool m_targetOk;
+};
+
+} // namespace
+
+EncodedCapture::EncodedCapture(const QPixmap& capture)
+  : m_cache(new Cache())
+{
+    m_cache->pixmap = capture;
+    if (!capture.isNull()) {
+        loadSettings();
+    }
+}
+
+EncodedCapture::EncodedCapture(const QImage& capture)
+  : m_cache(new Cache())
+{
+    m_cache->image = capture;
+    if (!capture.isNull()) {
+        loadSettings();
+    }
+}
+
+/**
+ * @brief The capture as a `QPixmap`, converted only once.
+ */
+const QPixmap& EncodedCapture::pixmap() const
+{
+    QMutexLocker locker(&m_cache->mutex);
+    if (m_cache->pixmap.isNull() && !m_cache->image.isNull()) {
+        m_cache->pixmap = QPixmap::fromImage(m_cache->image);
+    }
+    return m_cache->pixmap;
+}
+
+/**
+ * @brief The capture as a `QImage`, converted only once, on the GUI thread.
+ */
+QImage EncodedCapture::image() const
+{
+    QMutexLocker locker(&m_cache->mutex);
+    if (m_cache->image.isNull()) {
+        m_cache->image = m_cache->pixmap.toImage();
+    }
+    return m_cache->image;
+}
+
+/**
+ * @brief The capture encoded in `format`, e.g. "png" or "jpg".
+ *
+ * JPEG and PNG are encoded with the configured quality and compression
+ * level, WebP losslessly if enabled. The "png8" format is an indexed
+ * PNG, quantized to 256 colors if there are more (see `PaletteQuantizer`).
+ * The "rgba" format is the bare pixels, rows of 8-bit RGBA without padding
+ * nor header.
+ * @return An empty array if the capture could not be encoded, see
+ * `errorString`
+ */
+QByteArray EncodedCapture::data(const QString& format) const
+{
+    QString key = formatKey(format);
+    QByteArray bytes;
+    if (claim(key, bytes)) {
+        return bytes;
+    }
+
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::WriteOnly);
+    bool ok = encode(&buffer, key);
+    release(key, bytes, ok);
+    return ok ? bytes : QByteArray();
+}
+
+/**
+ * @brief Write the capture encoded in `format` to `device`.
+ *
+ * Unless the format has already been encoded, the encoder writes to the
+ * device as it goes, so the consumer gets the first bytes early. The result
+ * is only cached along the way if another sink needs the same format, which
+ * then waits for the encoding to be done.
+ */
+bool EncodedCapture::write(QIODevice* device, const QString& format) const
+{
+    QString key = formatKey(format);
+    QByteArray bytes;
+    if (claim(key, bytes)) {
+        if (device->write(bytes) != bytes.size()) {
+            setError(device->errorString());
+            return false;
+        }
+        return true;
+    }
+
+    if (!isShared(key)) {
+        bool ok = encode(device, key);
+        release(key, QByteArray(), false);
+        return ok;
+    }
+
+    TeeDevice tee(device, &bytes);
+    tee.open(QIODevice::WriteOnly);
+    bool ok = encode(&tee, key);
+    release(key, bytes, ok);
+    if (ok && !tee.targetOk()) {
+        setError(device->errorString());
+        return false;
+    }
+    return ok;
+}
+
+/**
+ * @brief Describe the last encoding error.
+ */
+QString EncodedCapture::errorString() const
+{
+    QMutexLocker locker(&m_cache->mutex);
+    return m_cache->error;
+}
+
+/**
+ * @brief Declare the formats the export tasks of the capture write, one per
+ * task. Those needed by several tasks are kept once `write` encoded them.
+ */
+void EncodedCapture::setSinkFormats(const QStringList& formats)
+{
+    QSet<QString> seen;
+    QMutexLocker locker(&m_cache->mutex);
+    m_cache->shared.clear();
+    for (const QString& format : formats) {
+        QString key = formatKey(format);
+        if (seen.contains(key)) {
+            m_cache->shared.insert(key);
+        }
+        seen.insert(key);
+    }
+}
+
+bool EncodedCapture::isShared(const QString& key) const
+{
+    QMutexLocker locker(&m_cache->mutex);
+    return m_cache->shared.contains(key);
+}
+
+/**
+ * @brief Get `key` from the cache, waiting for the thread encoding it if
+ * any.
+ * @return false if it isn't cached, the caller must then encode it and call
+ * `release`
+ */
+bool EncodedCapture::claim(const QString& key, QByteArray& bytes) const
+{
+    QMutexLocker locker(&m_cache->mutex);
+    while (m_cache->encoding.contains(key)) {
+        m_cache->encoded.wait(&m_cache->mutex);
+    }
+    auto it = m_cache->data.constFind(key);
+    if (it != m_cache->data.constEnd()) {
+        bytes = it.value();
+        return true;
+    }
+    m_cache->encoding.insert(key);
+    return false;
+}
+
+/**
+ * @brief Store `key` encoded by the caller of `claim`, and wake the threads
+ * waiting for it. A failed or uncached encoding is done again by the next
+ * caller.
+ */
+void EncodedCapture::release(const QString& key,
+                             const QByteArray& bytes,
+                             bool ok) const
+{
+    QMutexLocker locker(&m_cache->mutex);
+    if (ok) {
+        m_cache->data.insert(key, bytes);
+    }
+    m_cache->encoding.remove(key);
+    m_cache->encoded.wakeAll();
+}
+
+void EncodedCapture::setError(const QString& error) const
+{
+    QMutexLocker locker(&m_cache->mutex);
+    m_cache->error = error;
+}
+
+/**
+ * @brief Take a snapshot of the encoding settings, they must not be read from
+ * a worker thread.
+ */
+void EncodedCapture::loadSettings()
+{
+    ConfigHandler config;
+    m_cache->jpegQuality = config.jpegQuality();
+    m_cache->pngCompressionLevel = config.pngCompressionLevel();
+    m_cache->fastPngFilter = config.pngFilter() == "fast";
+    m_cache->webpLossless = config.webpLossless();
+}
+
+QString EncodedCapture::formatKey(const QString& format)
+{
+    QString key = format.toLower();
+    return key == "jpg" ? QStringLiteral("jpeg") : key;
+}
+
+bool EncodedCapture::encode(QIODevice* device, const QString& key) const
+{
+    QImage source = image();
+    if (key == "rgba") {
+        // Converted a band at a time to keep a second copy of the capture
+        // out of memory
+        const int bandRows = 64;
+        const int rowBytes = source.width() * 4;
+        for (int y = 0; y < source.height(); y += bandRows) {
+            int rows = qMin(bandRows, source.height() - y);
+            QImage band = source.copy(0, y, source.width(), rows)
+                            .convertToFormat(QImage::Format_RGBA8888);
+            for (int row = 0; row < rows; ++row) {
+                const char* line =
+                  reinterpret_cast<const char*>(band.constScanLine(row));
+                if (device->write(line, rowBytes) != rowBytes) {
+                    setError(device->errorString());
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+    if (key == "png8") {
+        QImage indexed = PaletteQuantizer::toIndexed(source);
+        // Captures with transparency and many colors stay true color
+        QImageWriter writer(device, "png");
+        writer.setCompression(m_cache->pngCompressionLevel);
+        if (!writer.write(indexed.isNull() ? source : indexed)) {
+            setError(writer.errorString());
+            return false;
+        }
+        return true;
+    }
+#ifdef USE_PARALLEL_PNG
+    if (key == "png") {
+        PngEncoder encoder(device);
+        encoder.setCompressionLevel(m_cache->pngCompressionLevel);
+        encoder.setFilter(m_cache->fastPngFilter ? PngEncoder::Fast
+                                                 : PngEncoder::Adaptive);
+        if (!encoder.write(source)) {
+            setError(encoder.errorString());
+            return false;
+        }
+        return true;
+    }
+#endif
+#ifdef USE_PARALLEL_JPEG
+    if (key == "jpeg") {
+        JpegEncoder encoder(device);
+        encoder.setQuality(m_cache->jpegQuality);
+        if (!encoder.write(source)) {
+            setError(encoder.errorString());
+            return false;
+        }
+        return true;
+    }
+#endif
+    QImageWriter writer(device, key.toUtf8());
+    if (key == "jpeg") {
+        writer.setQuality(m_cache->jpegQuality);
+    } else if (key == "png") {
+        writer.setCompression(m_cache->pngCompressionLevel);
+    } else if (key == "webp" && m_cache->webpLossless) {
+        // The WebP plugin switches to lossless encoding at quality 100
+        writer.setQuality(100);
+    }
+    if (!writer.write(source)) {
+        setError(writer.errorString());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QPixmap>
+#include <QSet>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+#include <QWaitCondition>
+
+class QIODevice;
+
+/**
+ * @brief A capture along with its encoded forms, each produced at most once.
+ *
+ * The export tasks (save, copy, print, upload) of a capture all receive the
+ * same `EncodedCapture`, so an image format requested by several of them is
+ * only encoded the first time. Copies of an `EncodedCapture` share the cache,
+ * and the returned `QByteArray`s are implicitly shared, so every sink reads
+ * the same buffer.
+ *
+ * It is implicitly constructible from a `QPixmap` so that the export
+ * functions can still be called with a plain pixmap.
+ *
+ * `write` streams the encoding to its device without keeping a copy of it,
+ * unless `setSinkFormats` declared that another task needs the same format.
+ * `data` always caches, its caller holds the encoding in memory anyway.
+ *
+ * The cache is shared between threads: the export jobs (see `ExportQueue`)
+ * fill it off the GUI thread, and a format being encoded by one thread is
+ * waited for by the others until it is done instead of being encoded again.
+ * The encoding settings are read when the capture is constructed.
+ *
+ * @note `pixmap()` is only valid on the GUI thread, and `image()` must have
+ * been called there once before a capture built from a `QPixmap` is handed to
+ * a worker thread.
+ */
+class EncodedCapture
+{
+public:
+    EncodedCapture(const QPixmap& capture = QPixmap());
+    explicit EncodedCapture(const QImage& capture);
+
+    const QPixmap& pixmap() const;
+    QImage image() const;
+    QByteArray data(const QString& format) const;
+    bool write(QIODevice* device, const QString& format) const;
+    QString errorString() const;
+    void setSinkFormats(const QStringList& formats);
+
+private:
+    struct Cache
+    {
+        // Guards everything below but the settings, which are not changed
+        // after construction
+        QMutex mutex;
+        QWaitCondition encoded;
+        QPixmap pixmap;
+        QImage image;
+        QHash<QString, QByteArray> data;
+        // Formats being encoded by a thread
+        QSet<QString> encoding;
+        // Formats needed by several export tasks, see `setSinkFormats`
+        QSet<QString> shared;
+        QString error;
+        int jpegQuality = -1;
+        int pngCompressionLevel = -1;
+        bool fastPngFilter = false;
+        bool webpLossless = false;
+    };
+
+    static QString formatKey(const QString& format);
+    bool claim(const QString& key, QByteArray& bytes) const;
+    void release(const QString& key, const QByteArray& bytes, bool ok) const;
+    bool isShared(const QString& key) const;
+    bool encode(QIODevice* device, const QString& key) const;
+    void setError(const QString& error) const;
+    void loadSettings();
+
+    QSharedPointer<Cache> m_cache;
+};
@@ -6,10 +6,96 @@
 #include "src/utils/confighandler.h"
 #include "src/utils/strfparse.h"
 #include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
 #include <ctime>
 #include <exception>
 #include <locale>
 
+#ifdef Q_OS_UNIX
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#ifndef RENAME_NOREPLACE
+#define RENAME_NOREPLACE (1 << 0)
+#endif
+#endif
+
+namespace {
+
+// Next number to try for the last name generated in a directory
+struct NameCounter
+{
+    QString name;
+    int next = 0;
+};
+
+// Only used from the export thread
+QHash<QString, NameCounter> nameCounters;
+
+enum ClaimResult
+{
+    Claimed,
+    Taken,
+    Failed
+};
+
+/**
+ * @brief Atomically move `source` to `path`, unless `path` exists.
+ */
+ClaimResult claimFile(const QString& source, const QString& path)
+{
+#ifdef Q_OS_UNIX
+    QByteArray from = QFile::encodeName(source), to = QFile::encodeName(path);
+    if (::link(from.constData(), to.constData()) == 0) {
+        ::unlink(from.constData());
+        return Claimed;
+    }
+    if (errno == EEXIST) {
+        return Taken;
+    }
+    if (errno != EPERM && errno != EOPNOTSUPP && errno != ENOSYS) {
+        return Failed;
+    }
+    // The file system doesn't support hard links, e.g. FAT
+#ifdef SYS_renameat2
+    if (syscall(SYS_renameat2,
+                AT_FDCWD,
+                from.constData(),
+                AT_FDCWD,
+                to.constData(),
+                RENAME_NOREPLACE) == 0) {
+        return Claimed;
+    }
+    if (errno == EEXIST) {
+        return Taken;
+    }
+    if (errno != EINVAL && errno != ENOSYS) {
+        return Failed;
+    }
+#endif
+    // Nothing atomic is supported, fall back to checking first
+    if (QFileInfo::exists(path)) {
+        return Taken;
+    }
+    return ::rename(from.constData(), to.constData()) == 0 ? Claimed : Failed;
+#else
+    if (QFileInfo::exists(path)) {
+        return Taken;
+    }
+    // Doesn't replace an existing file
+    if (QFile::rename(source, path)) {
+        return Claimed;
+    }
+    return QFileInfo::exists(path) ? Taken : Failed;
+#endif
+}
+
+} // namespace
+
 FileNameHandler::FileNameHandler(QObject* parent)
   : QObject(parent)
 {
@@ -41,8 +127,15 @@ QString FileNameHandler::parseFilename(const QString& name)
         res.chop(1);
     }
 
-    res =
-      QString::fromStdString(strfparse::format_time_string(name.toStdString()));
+    // The pattern is only parsed again when it changes
+    static QString cachedName;
+    static strfparse::time_pattern pattern;
+    if (res != cachedName) {
+        cachedName = res;
+        pattern = strfparse::compile_time_pattern(res.toStdString());
+    }
+    res = QString::fromStdString(
+      strfparse::format_time_string(pattern, std::time(nullptr)));
 
     // add the parsed pattern in a correct format for the filesystem
     res = res.replace(QLatin1String("/"), QStringLiteral("⁄"))
@@ -72,6 +165,67 @@ QString FileNameHandler::parseFilename(const QString& name)
  */
 QString FileNameHandler::properScreenshotPath(QString path,
                                               const QString& format)
+{
+    path = completePath(path, format);
+    if (!QFileInfo::exists(path)) {
+        return path;
+    } else {
+        return autoNumerateDuplicate(path);
+    }
+}
+
+/**
+ * @brief Move the complete file `source` to `path` (see `completePath`), or
+ * to the first "_NUM" variant of it that doesn't exist.
+ *
+ * The name is taken atomically, with a hard link where the file system
+ * supports it, so concurrent saves, even from several flameshot instances,
+ * never end up with the same path, and no existing file is replaced. The
+ * last "_NUM" used in each directory is remembered, so saving many captures
+ * with the same name (e.g. within the same second) doesn't check all the
+ * previous numbers again every time.
+ *
+ * It is meant to be called from the export thread only.
+ * @return The path, or an empty string if `source` could not be moved (see
+ * `errno` on Unix)
+ */
+QString FileNameHandler::claimScreenshotPath(const QString& source,
+                                             const QString& path)
+{
+    QFileInfo info(path);
+    QString directory = info.dir().absolutePath(),
+            filename = info.completeBaseName(), suffix = info.suffix();
+    if (!suffix.isEmpty()) {
+        suffix = QStringLiteral(".") + suffix;
+    }
+
+    NameCounter& counter = nameCounters[directory];
+    if (counter.name != filename + suffix) {
+        counter.name = filename + suffix;
+        counter.next = 0;
+    }
+    while (true) {
+        QString candidate = directory + "/" + filename;
+        if (counter.next > 0) {
+            candidate += "_" + QString::number(counter.next);
+        }
+        candidate += suffix;
+        ++counter.next;
+
+        ClaimResult res = claimFile(source, candidate);
+        if (res == Claimed) {
+            return candidate;
+        } else if (res == Failed) {
+            return {};
+        }
+    }
+}
+
+/**
+ * @brief `path` completed as by `properScreenshotPath`, but without the
+ * "_NUM" if it exists.
+ */
+QString FileNameHandler::completePath(QString path, const QString& format)
 {
     QFileInfo info(path);
     QString suffix = info.suffix();
@@ -94,12 +248,7 @@ QString FileNameHandler::properScreenshotPath(QString path,
     } else {
         path += ".png";
     }
-
-    if (!QFileInfo::exists(path)) {
-        return path;
-    } else {
-        return autoNumerateDuplicate(path);
-    }
+    return path;
 }
 
 QString FileNameHandler::autoNumerateDuplicate(const QString& path)
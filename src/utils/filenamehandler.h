@@ -16,6 +16,9 @@ public:
 
     QString properScreenshotPath(QString filename,
                                  const QString& format = QString());
+    QString completePath(QString path, const QString& format);
+    static QString claimScreenshotPath(const QString& source,
+                                       const QString& path);
 
     static const int MAX_CHARACTERS = 70;
 
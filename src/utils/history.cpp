@@ -1,7 +1,9 @@
 #include "history.h"
+#include "src/core/exportqueue.h"
 #include "src/utils/confighandler.h"
 #include <QDir>
 #include <QFile>
+#include <QImage>
 #include <QProcessEnvironment>
 #include <QStringList>
 
@@ -31,23 +33,28 @@ const QString& History::path()
 
 void History::save(const QPixmap& pixmap, const QString& fileName)
 {
-    // scale preview only in local disk
-    QPixmap pixmapScaled = QPixmap(pixmap);
-    if (pixmap.height() / HISTORYPIXMAP_MAX_PREVIEW_HEIGHT >=
-        pixmap.width() / HISTORYPIXMAP_MAX_PREVIEW_WIDTH) {
-        pixmapScaled = pixmap.scaledToHeight(HISTORYPIXMAP_MAX_PREVIEW_HEIGHT,
-                                             Qt::SmoothTransformation);
-    } else {
-        pixmapScaled = pixmap.scaledToWidth(HISTORYPIXMAP_MAX_PREVIEW_WIDTH,
-                                            Qt::SmoothTransformation);
-    }
-
-    // save preview
-    QFile file(path() + fileName);
-    file.open(QIODevice::WriteOnly);
-    pixmapScaled.save(&file, "PNG");
+    QImage image = pixmap.toImage();
+    QString filePath = path() + fileName;
+    ExportQueue::instance()->enqueue(
+      [image, filePath]() {
+          // scale preview only in local disk
+          QImage imageScaled;
+          if (image.height() / HISTORYPIXMAP_MAX_PREVIEW_HEIGHT >=
+              image.width() / HISTORYPIXMAP_MAX_PREVIEW_WIDTH) {
+              imageScaled = image.scaledToHeight(
+                HISTORYPIXMAP_MAX_PREVIEW_HEIGHT, Qt::SmoothTransformation);
+          } else {
+              imageScaled = image.scaledToWidth(
+                HISTORYPIXMAP_MAX_PREVIEW_WIDTH, Qt::SmoothTransformation);
+          }
 
-    history();
+          // save preview
+          QFile file(filePath);
+          file.open(QIODevice::WriteOnly);
+          imageScaled.save(&file, "PNG");
+      },
+      // Drops the oldest previews, needs the configuration
+      []() { History().history(); });
 }
 
 const QList<QString>& History::history()
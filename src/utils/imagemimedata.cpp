@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "imagemimedata.h"
+#include "abstractlogger.h"
+#include "src/utils/confighandler.h"
+#include <QImageWriter>
+
+namespace {
+
+const QString imageMimePrefix = QStringLiteral("image/");
+// Lets Qt convert the image to the native formats of the platform
+const QString qtImageMimeType = QStringLiteral("application/x-qt-image");
+
+} // namespace
+
+/**
+ * @param preferredType Image type offered first, e.g. "jpeg" when the user
+ * prefers JPEG for the clipboard
+ */
+ImageMimeData::ImageMimeData(const EncodedCapture& capture,
+                             const QString& preferredType)
+  : m_capture(capture)
+  , m_indexedPng(ConfigHandler().indexedPngForClipboard())
+{
+    QStringList types = {
+        preferredType, "png", "jpeg", "webp", "qoi", "bmp"
+    };
+    const QList<QByteArray> supported = QImageWriter::supportedMimeTypes();
+    for (const QString& type : types) {
+        QString mimeType = imageMimePrefix + type;
+        if (!m_formats.contains(mimeType) &&
+            supported.contains(mimeType.toUtf8())) {
+            m_formats.append(mimeType);
+        }
+    }
+    m_formats.append(qtImageMimeType);
+}
+
+bool ImageMimeData::hasFormat(const QString& mimeType) const
+{
+    return m_formats.contains(mimeType) || QMimeData::hasFormat(mimeType);
+}
+
+QStringList ImageMimeData::formats() const
+{
+    QStringList res = m_formats;
+    for (const QString& format : QMimeData::formats()) {
+        if (!res.contains(format)) {
+            res.append(format);
+        }
+    }
+    return res;
+}
+
+/**
+ * @brief Encode the capture in the requested type, unless it already was.
+ */
+QVariant ImageMimeData::retrieveData(const QString& mimeType,
+                                     QVariant::Type type) const
+{
+    if (mimeType == qtImageMimeType) {
+        return m_capture.image();
+    }
+    if (!m_formats.contains(mimeType)) {
+        return QMimeData::retrieveData(mimeType, type);
+    }
+    QString format = mimeType.mid(imageMimePrefix.size());
+    if (format == "png" && m_indexedPng) {
+        format = QStringLiteral("png8");
+    }
+    QByteArray bytes = m_capture.data(format);
+    if (bytes.isEmpty()) {
+        AbstractLogger::error()
+          << QObject::tr("Error while saving to clipboard") + ": " +
+               m_capture.errorString();
+    }
+    return bytes;
+}
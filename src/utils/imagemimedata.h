@@ -0,0 +1,38 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include "src/utils/encodedcapture.h"
+#include <QMimeData>
+#include <QStringList>
+
+/**
+ * @brief Clipboard data offering a capture in several image formats, encoded
+ * only when pasted.
+ *
+ * The capture is offered as PNG, JPEG, WebP, QOI and BMP (those supported by
+ * the image plugins), but nothing is encoded until a client actually requests
+ * one of them. The encodings are kept in the `EncodedCapture`, so
+ * pasting again, or a format that was already produced by another export
+ * task, costs nothing. PNG is offered indexed if enabled for the clipboard.
+ */
+class ImageMimeData : public QMimeData
+{
+    Q_OBJECT
+public:
+    ImageMimeData(const EncodedCapture& capture,
+                  const QString& preferredType = "png");
+
+    bool hasFormat(const QString& mimeType) const override;
+    QStringList formats() const override;
+
+protected:
+    QVariant retrieveData(const QString& mimeType,
+                          QVariant::Type type) const override;
+
+private:
+    EncodedCapture m_capture;
+    QStringList m_formats;
+    bool m_indexedPng;
+};
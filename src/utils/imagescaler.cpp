@@ -0,0 +1,260 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "imagescaler.h"
+#include <QRunnable>
+#include <QThreadPool>
+#include <QVector>
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <utility>
+
+namespace {
+
+const double lanczosRadius = 3.0;
+// Weights are fixed point numbers with this many fractional bits
+const int weightBits = 14;
+const int weightOne = 1 << weightBits;
+// Bands smaller than this aren't worth a task of their own
+const int minBandRows = 16;
+
+/**
+ * @brief The source pixels contributing to each pixel of a resampled row or
+ * column, and their weights.
+ */
+struct Taps
+{
+    int size = 0; // Room for the weights of each pixel
+    QVector<int> first;
+    QVector<int> count;
+    QVector<qint16> weights;
+};
+
+double sinc(double x)
+{
+    if (x == 0.0) {
+        return 1.0;
+    }
+    x *= M_PI;
+    return std::sin(x) / x;
+}
+
+double lanczos(double x)
+{
+    if (std::abs(x) >= lanczosRadius) {
+        return 0.0;
+    }
+    return sinc(x) * sinc(x / lanczosRadius);
+}
+
+Taps computeTaps(int sourceSize, int size)
+{
+    const double scale = double(sourceSize) / size;
+    // When downscaling, the filter is stretched to cover all source pixels
+    const double filterScale = qMax(scale, 1.0);
+    const double support = lanczosRadius * filterScale;
+
+    Taps taps;
+    taps.size = int(std::ceil(support)) * 2 + 1;
+    taps.first.resize(size);
+    taps.count.resize(size);
+    taps.weights.fill(0, taps.size * size);
+    QVector<double> weights(taps.size);
+    for (int i = 0; i < size; ++i) {
+        double center = (i + 0.5) * scale;
+        int first = qMax(int(center - support + 0.5), 0);
+        int last = qMin(int(center + support + 0.5), sourceSize);
+        int count = qMin(last - first, taps.size);
+
+        double total = 0.0;
+        for (int k = 0; k < count; ++k) {
+            weights[k] = lanczos((first + k - center + 0.5) / filterScale);
+            total += weights[k];
+        }
+        // Rounded so that the weights add up to exactly one, any error
+        // would shift the brightness of flat areas
+        qint16* fixed = taps.weights.data() + i * taps.size;
+        int sum = 0, largest = 0;
+        for (int k = 0; k < count; ++k) {
+            fixed[k] = qint16(qRound(weights[k] / total * weightOne));
+            sum += fixed[k];
+            if (fixed[k] > fixed[largest]) {
+                largest = k;
+            }
+        }
+        fixed[largest] += weightOne - sum;
+        taps.first[i] = first;
+        taps.count[i] = count;
+    }
+    return taps;
+}
+
+inline uchar toByte(int value)
+{
+    return uchar(qBound(0, (value + weightOne / 2) >> weightBits, 255));
+}
+
+/**
+ * @brief Resample a row of 32-bit pixels to `width` pixels.
+ */
+void resampleRow(const uchar* source, uchar* out, int width, const Taps& taps)
+{
+    for (int x = 0; x < width; ++x) {
+        const qint16* weights = taps.weights.constData() + x * taps.size;
+        const uchar* px = source + taps.first[x] * 4;
+        int sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+        for (int k = 0; k < taps.count[x]; ++k, px += 4) {
+            sum0 += weights[k] * px[0];
+            sum1 += weights[k] * px[1];
+            sum2 += weights[k] * px[2];
+            sum3 += weights[k] * px[3];
+        }
+        out[x * 4] = toByte(sum0);
+        out[x * 4 + 1] = toByte(sum1);
+        out[x * 4 + 2] = toByte(sum2);
+        out[x * 4 + 3] = toByte(sum3);
+    }
+}
+
+/**
+ * @brief Compute row `y` of the result of resampling the columns of
+ * `source`.
+ * @param sums Scratch space of one int per byte of a row
+ */
+void resampleColumns(const QImage& source,
+                     uchar* out,
+                     int y,
+                     const Taps& taps,
+                     QVector<int>& sums)
+{
+    const int bytes = source.width() * 4;
+    const qint16* weights = taps.weights.constData() + y * taps.size;
+    int* sum = sums.data();
+    std::fill(sum, sum + bytes, 0);
+    // Row by row, so that the inner loop runs over contiguous memory
+    for (int k = 0; k < taps.count[y]; ++k) {
+        const uchar* row = source.constScanLine(taps.first[y] + k);
+        const int weight = weights[k];
+        for (int i = 0; i < bytes; ++i) {
+            sum[i] += weight * row[i];
+        }
+    }
+    for (int i = 0; i < bytes; ++i) {
+        out[i] = toByte(sum[i]);
+    }
+}
+
+class BandTask : public QRunnable
+{
+public:
+    BandTask(const std::function<void(int, int)>& work, int first, int last)
+      : m_work(work)
+      , m_first(first)
+      , m_last(last)
+    {}
+
+    void run() override { m_work(m_first, m_last); }
+
+private:
+    const std::function<void(int, int)>& m_work;
+    int m_first;
+    int m_last;
+};
+
+/**
+ * @brief Split `rows` into bands and call `work(first, last)` for each of
+ * them on the available cores, returning once all of them are done.
+ */
+void runInBands(int rows, const std::function<void(int, int)>& work)
+{
+    QThreadPool pool;
+    int bands = qBound(1, rows / minBandRows, pool.maxThreadCount());
+    for (int i = 0; i < bands; ++i) {
+        pool.start(
+          new BandTask(work, rows * i / bands, rows * (i + 1) / bands));
+    }
+    pool.waitForDone();
+}
+
+} // namespace
+
+namespace ImageScaler {
+
+/**
+ * @brief Resample `image` to `size`, ignoring its aspect ratio.
+ */
+QImage scaled(const QImage& image, const QSize& size)
+{
+    if (image.isNull() || size.isEmpty()) {
+        return {};
+    }
+    if (size == image.size()) {
+        return image;
+    }
+
+    const bool alpha = image.hasAlphaChannel();
+    const QImage::Format format =
+      alpha ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32;
+    const QImage source = image.convertToFormat(format);
+    QImage horizontal(size.width(), source.height(), format);
+    QImage result(size, format);
+    if (source.isNull() || horizontal.isNull() || result.isNull()) {
+        return {};
+    }
+
+    // The bits are taken once, the workers must not detach the images
+    uchar* horizontalBits = horizontal.bits();
+    const int horizontalStride = horizontal.bytesPerLine();
+    const Taps columnTaps = computeTaps(source.width(), size.width());
+    runInBands(source.height(), [&](int first, int last) {
+        for (int y = first; y < last; ++y) {
+            resampleRow(source.constScanLine(y),
+                        horizontalBits + y * horizontalStride,
+                        size.width(),
+                        columnTaps);
+        }
+    });
+
+    uchar* resultBits = result.bits();
+    const int resultStride = result.bytesPerLine();
+    const Taps rowTaps = computeTaps(source.height(), size.height());
+    runInBands(size.height(), [&](int first, int last) {
+        QVector<int> sums(size.width() * 4);
+        for (int y = first; y < last; ++y) {
+            uchar* out = resultBits + y * resultStride;
+            resampleColumns(horizontal, out, y, rowTaps, sums);
+            if (alpha) {
+                // The negative lobes of the filter can push a color above
+                // its alpha, which is not a valid premultiplied pixel
+                auto* line = reinterpret_cast<QRgb*>(out);
+                for (int x = 0; x < size.width(); ++x) {
+                    int a = qAlpha(line[x]);
+                    line[x] = qRgba(qMin(qRed(line[x]), a),
+                                    qMin(qGreen(line[x]), a),
+                                    qMin(qBlue(line[x]), a),
+                                    a);
+                }
+            }
+        }
+    });
+    return result;
+}
+
+/**
+ * @brief Downscale `image` to fit within `maxSize`, keeping its aspect ratio.
+ * @return The image itself if it already fits
+ */
+QImage fitted(const QImage& image, const QSize& maxSize)
+{
+    if (image.isNull() || !maxSize.isValid() ||
+        (image.width() <= maxSize.width() &&
+         image.height() <= maxSize.height())) {
+        return image;
+    }
+    QSize size = image.size().scaled(maxSize, Qt::KeepAspectRatio);
+    return scaled(image, size.expandedTo(QSize(1, 1)));
+}
+
+} // namespace
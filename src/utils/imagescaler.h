@@ -0,0 +1,24 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include <QImage>
+#include <QSize>
+
+/**
+ * @brief Lanczos-3 resampling of captures, used to downscale them before
+ * they are exported.
+ *
+ * The filter is separable: the rows are resampled horizontally, then the
+ * columns vertically, each pass split into bands of rows processed on all
+ * cores. Weights are precomputed in fixed point, so the inner loops are
+ * plain integer multiply-adds that the compiler vectorizes.
+ */
+namespace ImageScaler { // namespace
+
+QImage scaled(const QImage& image, const QSize& size);
+
+QImage fitted(const QImage& image, const QSize& maxSize);
+
+} // namespace
@@ -0,0 +1,304 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "jpegencoder.h"
+#include <QByteArray>
+#include <QIODevice>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
+#include <csetjmp>
+#include <cstdio>
+
+extern "C"
+{
+#include <jpeglib.h>
+}
+
+namespace {
+
+// jpeg_set_defaults() subsamples the chroma 2x2, making MCUs of 16x16 pixels
+const int mcuSize = 16;
+// Stripes smaller than this aren't worth a task of their own
+const int minStripeMcuRows = 4;
+// Output buffer growth step of the stripe encoders
+const int bufferStep = 64 * 1024;
+
+const uchar markerSof0 = 0xc0;
+const uchar markerRst0 = 0xd0;
+const uchar markerSos = 0xda;
+const uchar markerDri = 0xdd;
+
+struct ErrorManager
+{
+    jpeg_error_mgr pub;
+    jmp_buf jump;
+    char message[JMSG_LENGTH_MAX];
+};
+
+void errorExit(j_common_ptr info)
+{
+    auto* err = reinterpret_cast<ErrorManager*>(info->err);
+    (*info->err->format_message)(info, err->message);
+    longjmp(err->jump, 1);
+}
+
+struct Destination
+{
+    jpeg_destination_mgr pub;
+    QByteArray* data;
+};
+
+void initDestination(j_compress_ptr info)
+{
+    auto* dest = reinterpret_cast<Destination*>(info->dest);
+    dest->data->resize(bufferStep);
+    dest->pub.next_output_byte = reinterpret_cast<JOCTET*>(dest->data->data());
+    dest->pub.free_in_buffer = dest->data->size();
+}
+
+boolean emptyOutputBuffer(j_compress_ptr info)
+{
+    auto* dest = reinterpret_cast<Destination*>(info->dest);
+    int used = dest->data->size();
+    dest->data->resize(used + qMax(used, bufferStep));
+    dest->pub.next_output_byte =
+      reinterpret_cast<JOCTET*>(dest->data->data()) + used;
+    dest->pub.free_in_buffer = dest->data->size() - used;
+    return TRUE;
+}
+
+void termDestination(j_compress_ptr info)
+{
+    auto* dest = reinterpret_cast<Destination*>(info->dest);
+    dest->data->resize(dest->data->size() -
+                       static_cast<int>(dest->pub.free_in_buffer));
+}
+
+int readUint16(const QByteArray& data, int pos)
+{
+    return uchar(data[pos]) << 8 | uchar(data[pos + 1]);
+}
+
+void appendUint16(QByteArray& data, int value)
+{
+    data.append(char(value >> 8));
+    data.append(char(value & 0xff));
+}
+
+/**
+ * @brief Locate the scan of a JPEG written by libjpeg.
+ * @param sos Set to the offset of the SOS marker, which ends the headers
+ * @param scan Set to the offset of the entropy-coded data
+ * @return false if the data is not a complete JPEG
+ */
+bool findScan(const QByteArray& jpeg, int& sos, int& scan)
+{
+    int pos = 2; // SOI
+    while (pos + 4 <= jpeg.size() && uchar(jpeg[pos]) == 0xff) {
+        int length = readUint16(jpeg, pos + 2);
+        if (uchar(jpeg[pos + 1]) == markerSos) {
+            sos = pos;
+            scan = pos + 2 + length;
+            // The scan is followed by the EOI marker
+            return scan + 2 <= jpeg.size() &&
+                   uchar(jpeg[jpeg.size() - 2]) == 0xff &&
+                   uchar(jpeg[jpeg.size() - 1]) == 0xd9;
+        }
+        pos += 2 + length;
+    }
+    return false;
+}
+
+class StripeTask : public QRunnable
+{
+public:
+    StripeTask(const QImage& image, int firstRow, int lastRow, int quality)
+      : m_image(image)
+      , m_firstRow(firstRow)
+      , m_lastRow(lastRow)
+      , m_quality(quality)
+      , m_ok(false)
+    {
+        setAutoDelete(false);
+    }
+
+    void run() override
+    {
+        encode();
+        m_finished.release();
+    }
+
+    /**
+     * @brief Block until the stripe has been encoded.
+     */
+    void waitForFinished() { m_finished.acquire(); }
+
+    const QByteArray& data() const { return m_data; }
+    QString errorString() const { return m_error; }
+    bool ok() const { return m_ok; }
+
+private:
+    void encode()
+    {
+        jpeg_compress_struct info;
+        ErrorManager err;
+        Destination dest;
+        info.err = jpeg_std_error(&err.pub);
+        err.pub.error_exit = errorExit;
+        if (setjmp(err.jump)) {
+            m_error = QString::fromLocal8Bit(err.message);
+            jpeg_destroy_compress(&info);
+            return;
+        }
+
+        jpeg_create_compress(&info);
+        dest.pub.init_destination = initDestination;
+        dest.pub.empty_output_buffer = emptyOutputBuffer;
+        dest.pub.term_destination = termDestination;
+        dest.data = &m_data;
+        info.dest = &dest.pub;
+
+        info.image_width = m_image.width();
+        info.image_height = m_lastRow - m_firstRow;
+        info.input_components = 3;
+        info.in_color_space = JCS_RGB;
+        jpeg_set_defaults(&info);
+        // Every stripe must use the same tables, so no optimized Huffman
+        // tables nor progressive scans
+        jpeg_set_quality(&info, m_quality, TRUE);
+        if (m_image.dotsPerMeterX() > 0 && m_image.dotsPerMeterY() > 0) {
+            info.density_unit = 1; // dots per inch
+            info.X_density = (m_image.dotsPerMeterX() * 254 + 5000) / 10000;
+            info.Y_density = (m_image.dotsPerMeterY() * 254 + 5000) / 10000;
+        }
+
+        jpeg_start_compress(&info, TRUE);
+        while (info.next_scanline < info.image_height) {
+            auto* row = const_cast<JSAMPLE*>(
+              m_image.constScanLine(m_firstRow + info.next_scanline));
+            jpeg_write_scanlines(&info, &row, 1);
+        }
+        jpeg_finish_compress(&info);
+        jpeg_destroy_compress(&info);
+        m_ok = true;
+    }
+
+    const QImage& m_image;
+    int m_firstRow;
+    int m_lastRow;
+    int m_quality;
+    QByteArray m_data;
+    QString m_error;
+    bool m_ok;
+    QSemaphore m_finished;
+};
+
+} // namespace
+
+JpegEncoder::JpegEncoder(QIODevice* device)
+  : m_device(device)
+  , m_quality(75)
+{}
+
+/**
+ * @brief Set the quality, from 0 (smallest) to 100 (best).
+ */
+void JpegEncoder::setQuality(int quality)
+{
+    m_quality = qBound(0, quality, 100);
+}
+
+bool JpegEncoder::write(const QImage& source)
+{
+    if (source.isNull()) {
+        m_error = QStringLiteral("Image is empty");
+        return false;
+    }
+    if (source.width() > JPEG_MAX_DIMENSION ||
+        source.height() > JPEG_MAX_DIMENSION) {
+        m_error = QStringLiteral("Image is too large for JPEG");
+        return false;
+    }
+    const QImage image = source.convertToFormat(QImage::Format_RGB888);
+
+    // The restart interval is counted in MCUs and stored on 16 bits
+    const int mcusPerRow = (image.width() + mcuSize - 1) / mcuSize;
+    const int mcuRows = (image.height() + mcuSize - 1) / mcuSize;
+    const int threads = QThread::idealThreadCount();
+    int stripeMcuRows =
+      qMax(minStripeMcuRows, (mcuRows + threads - 1) / threads);
+    stripeMcuRows = qMax(1, qMin(stripeMcuRows, 0xffff / mcusPerRow));
+    const int stripeRows = stripeMcuRows * mcuSize;
+    const int stripes = (image.height() + stripeRows - 1) / stripeRows;
+
+    QVector<StripeTask*> tasks;
+    QThreadPool pool;
+    pool.setMaxThreadCount(qMin(stripes, threads));
+    for (int i = 0; i < stripes; ++i) {
+        int first = i * stripeRows;
+        int last = qMin(first + stripeRows, image.height());
+        tasks.append(new StripeTask(image, first, last, m_quality));
+        pool.start(tasks.last());
+    }
+
+    // Each stripe is written as soon as it and the ones before it are done,
+    // so the output starts while the next stripes are still encoded
+    bool ok = true;
+    for (int i = 0; i < stripes && ok; ++i) {
+        StripeTask* task = tasks[i];
+        task->waitForFinished();
+        int sos = 0, scan = 0;
+        if (!task->ok() || !findScan(task->data(), sos, scan)) {
+            m_error = task->ok() ? QStringLiteral("Invalid stripe")
+                                 : task->errorString();
+            ok = false;
+            break;
+        }
+
+        const QByteArray& data = task->data();
+        QByteArray head, tail;
+        if (i == 0) {
+            // The headers of the first stripe, for the full height
+            head = data.left(sos);
+            for (int pos = 2; pos + 9 <= head.size();
+                 pos += 2 + readUint16(head, pos + 2)) {
+                if (uchar(head[pos + 1]) == markerSof0) {
+                    head[pos + 5] = char(image.height() >> 8);
+                    head[pos + 6] = char(image.height() & 0xff);
+                }
+            }
+            if (stripes > 1) {
+                head.append(char(0xff));
+                head.append(char(markerDri));
+                appendUint16(head, 4);
+                appendUint16(head, stripeMcuRows * mcusPerRow);
+            }
+            head.append(data.mid(sos, scan - sos));
+        }
+        if (i < stripes - 1) {
+            tail.append(char(0xff));
+            tail.append(char(markerRst0 + i % 8));
+        } else {
+            tail.append(data.right(2)); // EOI
+        }
+
+        int length = data.size() - 2 - scan;
+        ok = m_device->write(head) == head.size() &&
+             m_device->write(data.constData() + scan, length) == length &&
+             m_device->write(tail) == tail.size();
+        if (!ok) {
+            m_error = m_device->errorString();
+        }
+    }
+    pool.waitForDone();
+    qDeleteAll(tasks);
+    return ok;
+}
+
+QString JpegEncoder::errorString() const
+{
+    return m_error;
+}
@@ -0,0 +1,37 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include <QImage>
+#include <QString>
+
+class QIODevice;
+
+/**
+ * @brief Baseline JPEG encoder compressing horizontal stripes of the image in
+ * parallel.
+ *
+ * Each stripe is a whole number of MCU rows and is encoded by libjpeg on its
+ * own thread, as an image of its own, with the same (standard) tables. The
+ * entropy-coded data of the stripes is then joined with restart markers, the
+ * restart interval being the number of MCUs in a stripe: a decoder resets
+ * the DC predictions at each marker, exactly like each stripe started from
+ * scratch. The result is a single regular JPEG, with the same pixels as if
+ * it was encoded in one pass.
+ */
+class JpegEncoder
+{
+public:
+    explicit JpegEncoder(QIODevice* device);
+
+    void setQuality(int quality);
+
+    bool write(const QImage& image);
+    QString errorString() const;
+
+private:
+    QIODevice* m_device;
+    int m_quality;
+    QString m_error;
+};
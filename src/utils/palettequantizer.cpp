@@ -0,0 +1,288 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "palettequantizer.h"
+#include <QHash>
+#include <QVector>
+#include <algorithm>
+#include <climits>
+
+namespace {
+
+const int maxColors = 256;
+const int histogramBits = 5;
+const int histogramSize = 1 << (3 * histogramBits);
+// Larger captures are sampled to build the histogram
+const qint64 maxSamples = 1 << 20;
+
+inline int histogramBin(QRgb color)
+{
+    const int shift = 8 - histogramBits;
+    return (qRed(color) >> shift) << (2 * histogramBits) |
+           (qGreen(color) >> shift) << histogramBits | qBlue(color) >> shift;
+}
+
+inline int channel(int bin, int index)
+{
+    const int mask = (1 << histogramBits) - 1;
+    return (bin >> ((2 - index) * histogramBits)) & mask;
+}
+
+struct Bin
+{
+    qint64 count = 0;
+    qint64 red = 0, green = 0, blue = 0;
+};
+
+// A range of the non-empty bins of the histogram
+struct Box
+{
+    int first, last;
+    qint64 count;
+    int min[3], max[3];
+};
+
+/**
+ * @brief Convert `image` losslessly, if it doesn't have too many colors.
+ * @return A null image if there are more than 256 colors
+ */
+QImage exactIndexed(const QImage& image)
+{
+    QImage result(image.size(), QImage::Format_Indexed8);
+    QHash<QRgb, int> indices;
+    QVector<QRgb> table;
+    for (int y = 0; y < image.height(); ++y) {
+        const auto* line =
+          reinterpret_cast<const QRgb*>(image.constScanLine(y));
+        uchar* out = result.scanLine(y);
+        // Screenshots are mostly runs of the same color
+        QRgb last = ~line[0];
+        int index = 0;
+        for (int x = 0; x < image.width(); ++x) {
+            if (line[x] != last) {
+                last = line[x];
+                auto it = indices.constFind(last);
+                if (it != indices.constEnd()) {
+                    index = it.value();
+                } else if (table.size() < maxColors) {
+                    index = table.size();
+                    indices.insert(last, index);
+                    table.append(last);
+                } else {
+                    return {};
+                }
+            }
+            out[x] = uchar(index);
+        }
+    }
+    result.setColorTable(table);
+    return result;
+}
+
+bool isOpaque(const QImage& image)
+{
+    for (int y = 0; y < image.height(); ++y) {
+        const auto* line =
+          reinterpret_cast<const QRgb*>(image.constScanLine(y));
+        for (int x = 0; x < image.width(); ++x) {
+            if (qAlpha(line[x]) != 255) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void updateBounds(Box& box, const QVector<int>& bins, const QVector<Bin>& hist)
+{
+    box.count = 0;
+    for (int c = 0; c < 3; ++c) {
+        box.min[c] = (1 << histogramBits) - 1;
+        box.max[c] = 0;
+    }
+    for (int i = box.first; i < box.last; ++i) {
+        box.count += hist[bins[i]].count;
+        for (int c = 0; c < 3; ++c) {
+            box.min[c] = qMin(box.min[c], channel(bins[i], c));
+            box.max[c] = qMax(box.max[c], channel(bins[i], c));
+        }
+    }
+}
+
+int longestAxis(const Box& box)
+{
+    int axis = 0;
+    for (int c = 1; c < 3; ++c) {
+        if (box.max[c] - box.min[c] > box.max[axis] - box.min[axis]) {
+            axis = c;
+        }
+    }
+    return axis;
+}
+
+/**
+ * @brief Build a palette for `image` by median cut.
+ */
+QVector<QRgb> medianCut(const QImage& image)
+{
+    QVector<Bin> hist(histogramSize);
+    const qint64 pixels = qint64(image.width()) * image.height();
+    const qint64 step = qMax<qint64>(1, pixels / maxSamples);
+    for (qint64 i = 0; i < pixels; i += step) {
+        int y = int(i / image.width()), x = int(i % image.width());
+        QRgb color =
+          reinterpret_cast<const QRgb*>(image.constScanLine(y))[x];
+        Bin& bin = hist[histogramBin(color)];
+        ++bin.count;
+        bin.red += qRed(color);
+        bin.green += qGreen(color);
+        bin.blue += qBlue(color);
+    }
+
+    QVector<int> bins;
+    for (int i = 0; i < histogramSize; ++i) {
+        if (hist[i].count > 0) {
+            bins.append(i);
+        }
+    }
+    QVector<Box> boxes;
+    Box all;
+    all.first = 0;
+    all.last = bins.size();
+    updateBounds(all, bins, hist);
+    boxes.append(all);
+
+    while (boxes.size() < maxColors) {
+        // Split the box where the error is likely the largest: many pixels
+        // over a wide range of colors
+        int best = -1;
+        qint64 bestScore = 0;
+        for (int i = 0; i < boxes.size(); ++i) {
+            const Box& box = boxes[i];
+            int axis = longestAxis(box);
+            qint64 score = box.count * (box.max[axis] - box.min[axis]);
+            if (box.last - box.first > 1 && score > bestScore) {
+                best = i;
+                bestScore = score;
+            }
+        }
+        if (best < 0) {
+            break;
+        }
+
+        Box& box = boxes[best];
+        int axis = longestAxis(box);
+        std::sort(bins.begin() + box.first,
+                  bins.begin() + box.last,
+                  [axis](int a, int b) {
+                      return channel(a, axis) < channel(b, axis);
+                  });
+        // The median by pixel count, leaving at least one bin on each side
+        qint64 half = box.count / 2, count = 0;
+        int split = box.first + 1;
+        for (int i = box.first; i < box.last - 1; ++i) {
+            count += hist[bins[i]].count;
+            split = i + 1;
+            if (count >= half) {
+                break;
+            }
+        }
+        Box upper = box;
+        upper.first = split;
+        box.last = split;
+        updateBounds(box, bins, hist);
+        updateBounds(upper, bins, hist);
+        boxes.append(upper);
+    }
+
+    QVector<QRgb> palette;
+    for (const Box& box : qAsConst(boxes)) {
+        Bin sum;
+        for (int i = box.first; i < box.last; ++i) {
+            const Bin& bin = hist[bins[i]];
+            sum.count += bin.count;
+            sum.red += bin.red;
+            sum.green += bin.green;
+            sum.blue += bin.blue;
+        }
+        palette.append(qRgb(int(sum.red / sum.count),
+                            int(sum.green / sum.count),
+                            int(sum.blue / sum.count)));
+    }
+    return palette;
+}
+
+int nearestColor(const QVector<QRgb>& palette, int r, int g, int b)
+{
+    int best = 0, bestDistance = INT_MAX;
+    for (int i = 0; i < palette.size(); ++i) {
+        int dr = qRed(palette[i]) - r, dg = qGreen(palette[i]) - g,
+            db = qBlue(palette[i]) - b;
+        int distance = dr * dr + dg * dg + db * db;
+        if (distance < bestDistance) {
+            best = i;
+            bestDistance = distance;
+        }
+    }
+    return best;
+}
+
+QImage quantized(const QImage& image)
+{
+    const QVector<QRgb> palette = medianCut(image);
+    // Nearest palette color of each histogram bin, found when first needed
+    QVector<short> nearest(histogramSize, -1);
+    const int shift = 8 - histogramBits;
+    const int center = 1 << (shift - 1);
+
+    QImage result(image.size(), QImage::Format_Indexed8);
+    for (int y = 0; y < image.height(); ++y) {
+        const auto* line =
+          reinterpret_cast<const QRgb*>(image.constScanLine(y));
+        uchar* out = result.scanLine(y);
+        for (int x = 0; x < image.width(); ++x) {
+            int bin = histogramBin(line[x]);
+            if (nearest[bin] < 0) {
+                nearest[bin] = short(
+                  nearestColor(palette,
+                               channel(bin, 0) << shift | center,
+                               channel(bin, 1) << shift | center,
+                               channel(bin, 2) << shift | center));
+            }
+            out[x] = uchar(nearest[bin]);
+        }
+    }
+    result.setColorTable(palette);
+    return result;
+}
+
+} // namespace
+
+namespace PaletteQuantizer {
+
+/**
+ * @brief Convert `image` to `QImage::Format_Indexed8`.
+ * @return A null image if it can't be converted: it has more than 256 colors
+ * and some transparency, which the palette doesn't model
+ */
+QImage toIndexed(const QImage& image)
+{
+    if (image.isNull()) {
+        return {};
+    }
+    const QImage source = image.convertToFormat(
+      image.hasAlphaChannel() ? QImage::Format_ARGB32 : QImage::Format_RGB32);
+
+    QImage result = exactIndexed(source);
+    if (result.isNull() &&
+        (!source.hasAlphaChannel() || isOpaque(source))) {
+        result = quantized(source);
+    }
+    if (!result.isNull()) {
+        result.setDotsPerMeterX(image.dotsPerMeterX());
+        result.setDotsPerMeterY(image.dotsPerMeterY());
+    }
+    return result;
+}
+
+} // namespace
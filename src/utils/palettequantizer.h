@@ -0,0 +1,22 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include <QImage>
+
+/**
+ * @brief Conversion of captures to 8-bit indexed images, for smaller PNGs.
+ *
+ * Screenshots of user interfaces and terminals rarely use more than a few
+ * hundred colors. When a capture has at most 256 of them, it is converted
+ * losslessly. Otherwise a palette is built by median cut on a histogram of a
+ * sample of the pixels (5 bits per channel), and each pixel is mapped to the
+ * nearest palette color, without dithering so that flat areas and text stay
+ * clean.
+ */
+namespace PaletteQuantizer { // namespace
+
+QImage toIndexed(const QImage& image);
+
+} // namespace
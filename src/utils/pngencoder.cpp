@@ -0,0 +1,404 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "pngencoder.h"
+#include <QIODevice>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
+#include <QtEndian>
+#include <cstdlib>
+#include <cstring>
+#include <zlib.h>
+
+namespace {
+
+// Strips smaller than this compress noticeably worse than a single stream
+const int minStripRows = 64;
+
+enum FilterType : uchar
+{
+    FilterNone = 0,
+    FilterSub = 1,
+    FilterUp = 2,
+    FilterAverage = 3,
+    FilterPaeth = 4
+};
+
+void appendUint32(QByteArray& data, quint32 value)
+{
+    uchar bytes[4];
+    qToBigEndian(value, bytes);
+    data.append(reinterpret_cast<const char*>(bytes), 4);
+}
+
+uchar paeth(int a, int b, int c)
+{
+    int p = a + b - c;
+    int pa = std::abs(p - a);
+    int pb = std::abs(p - b);
+    int pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) {
+        return a;
+    }
+    return pb <= pc ? b : c;
+}
+
+/**
+ * @brief Apply `type` to `row` and write the filter byte and the result to
+ * `out`.
+ * @param prev The previous row, or nullptr for the first row of the image
+ */
+void filterRow(FilterType type,
+               const uchar* row,
+               const uchar* prev,
+               int rowBytes,
+               int bpp,
+               uchar* out)
+{
+    out[0] = type;
+    uchar* res = out + 1;
+    if (prev == nullptr) {
+        // Same as filtering with a row of zeros
+        if (type == FilterUp) {
+            type = FilterNone;
+        } else if (type == FilterPaeth) {
+            type = FilterSub;
+        }
+    }
+    switch (type) {
+        case FilterNone:
+            memcpy(res, row, rowBytes);
+            break;
+        case FilterSub:
+            memcpy(res, row, bpp);
+            for (int i = bpp; i < rowBytes; ++i) {
+                res[i] = row[i] - row[i - bpp];
+            }
+            break;
+        case FilterUp:
+            for (int i = 0; i < rowBytes; ++i) {
+                res[i] = row[i] - prev[i];
+            }
+            break;
+        case FilterAverage:
+            for (int i = 0; i < rowBytes; ++i) {
+                int left = i >= bpp ? row[i - bpp] : 0;
+                int up = prev != nullptr ? prev[i] : 0;
+                res[i] = row[i] - ((left + up) >> 1);
+            }
+            break;
+        case FilterPaeth:
+            for (int i = 0; i < bpp; ++i) {
+                res[i] = row[i] - prev[i];
+            }
+            for (int i = bpp; i < rowBytes; ++i) {
+                res[i] = row[i] - paeth(row[i - bpp], prev[i], prev[i - bpp]);
+            }
+            break;
+    }
+}
+
+/**
+ * @brief Estimate how well a filtered row compresses, lower is better.
+ */
+quint64 filterCost(const uchar* filtered, int rowBytes)
+{
+    quint64 cost = 0;
+    for (int i = 1; i <= rowBytes; ++i) {
+        cost += std::abs(static_cast<signed char>(filtered[i]));
+    }
+    return cost;
+}
+
+class StripTask : public QRunnable
+{
+public:
+    StripTask(const QImage& image,
+              int firstRow,
+              int lastRow,
+              int level,
+              PngEncoder::Filter filter,
+              bool isFinal)
+      : m_image(image)
+      , m_firstRow(firstRow)
+      , m_lastRow(lastRow)
+      , m_level(level)
+      , m_filter(filter)
+      , m_isFinal(isFinal)
+      , m_adler(adler32(0, Z_NULL, 0))
+      , m_ok(false)
+    {
+        setAutoDelete(false);
+    }
+
+    void run() override
+    {
+        encode();
+        m_finished.release();
+    }
+
+    /**
+     * @brief Block until the strip has been compressed.
+     */
+    void waitForFinished() { m_finished.acquire(); }
+
+    const QByteArray& data() const { return m_data; }
+    uLong adler() const { return m_adler; }
+    quint64 length() const { return m_length; }
+    bool ok() const { return m_ok; }
+
+private:
+    void encode()
+    {
+        z_stream stream = {};
+        // Raw deflate, the zlib header and trailer are written by the encoder
+        if (deflateInit2(
+              &stream, m_level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) !=
+            Z_OK) {
+            return;
+        }
+
+        const int bpp = m_image.depth() / 8;
+        const int rowBytes = m_image.width() * bpp;
+        const int rows = m_lastRow - m_firstRow;
+        m_data.resize(static_cast<int>(
+          deflateBound(&stream, static_cast<uLong>(rows) * (rowBytes + 1)) +
+          64));
+        stream.next_out = reinterpret_cast<Bytef*>(m_data.data());
+        stream.avail_out = m_data.size();
+
+        const int candidates = m_filter == PngEncoder::Adaptive ? 5 : 1;
+        QByteArray scratch(candidates * (rowBytes + 1), Qt::Uninitialized);
+        bool ok = true;
+        for (int y = m_firstRow; y < m_lastRow && ok; ++y) {
+            const uchar* row = m_image.constScanLine(y);
+            const uchar* prev = y > 0 ? m_image.constScanLine(y - 1) : nullptr;
+            auto* filtered = reinterpret_cast<uchar*>(scratch.data());
+            if (m_filter == PngEncoder::Fast) {
+                filterRow(prev != nullptr ? FilterUp : FilterNone,
+                          row,
+                          prev,
+                          rowBytes,
+                          bpp,
+                          filtered);
+            } else {
+                quint64 bestCost = 0;
+                uchar* best = filtered;
+                for (int type = FilterNone; type <= FilterPaeth; ++type) {
+                    uchar* out = filtered + type * (rowBytes + 1);
+                    filterRow(static_cast<FilterType>(type),
+                              row,
+                              prev,
+                              rowBytes,
+                              bpp,
+                              out);
+                    quint64 cost = filterCost(out, rowBytes);
+                    if (type == FilterNone || cost < bestCost) {
+                        bestCost = cost;
+                        best = out;
+                    }
+                }
+                filtered = best;
+            }
+            m_adler = adler32(m_adler, filtered, rowBytes + 1);
+            stream.next_in = filtered;
+            stream.avail_in = rowBytes + 1;
+            ok = deflateAll(stream, Z_NO_FLUSH);
+        }
+        // All strips but the last one end on a byte boundary without the
+        // final block flag, so they can be concatenated
+        ok = ok && deflateAll(stream, m_isFinal ? Z_FINISH : Z_SYNC_FLUSH);
+        m_data.resize(static_cast<int>(stream.total_out));
+        m_length = static_cast<quint64>(rows) * (rowBytes + 1);
+        m_ok = ok;
+        deflateEnd(&stream);
+    }
+
+    bool deflateAll(z_stream& stream, int flush)
+    {
+        do {
+            if (stream.avail_out == 0) {
+                m_data.resize(m_data.size() * 2);
+                stream.next_out =
+                  reinterpret_cast<Bytef*>(m_data.data()) + stream.total_out;
+                stream.avail_out = m_data.size() - stream.total_out;
+            }
+            int res = deflate(&stream, flush);
+            if (res == Z_STREAM_ERROR) {
+                return false;
+            }
+        } while (stream.avail_out == 0);
+        return true;
+    }
+
+    const QImage& m_image;
+    int m_firstRow;
+    int m_lastRow;
+    int m_level;
+    PngEncoder::Filter m_filter;
+    bool m_isFinal;
+    QByteArray m_data;
+    uLong m_adler;
+    quint64 m_length = 0;
+    bool m_ok;
+    QSemaphore m_finished;
+};
+
+/**
+ * @brief Second byte of the zlib header, matching the compression level.
+ */
+char zlibFlags(int level)
+{
+    if (level <= 1) {
+        return 0x01;
+    } else if (level <= 5) {
+        return 0x5e;
+    } else if (level == 6) {
+        return static_cast<char>(0x9c);
+    }
+    return static_cast<char>(0xda);
+}
+
+} // namespace
+
+PngEncoder::PngEncoder(QIODevice* device)
+  : m_device(device)
+  , m_level(Z_DEFAULT_COMPRESSION)
+  , m_filter(Adaptive)
+{}
+
+/**
+ * @brief Set the zlib compression level, from 0 (none) to 9 (best).
+ */
+void PngEncoder::setCompressionLevel(int level)
+{
+    m_level = qBound(0, level, 9);
+}
+
+void PngEncoder::setFilter(Filter filter)
+{
+    m_filter = filter;
+}
+
+bool PngEncoder::write(const QImage& source)
+{
+    if (source.isNull()) {
+        m_error = QStringLiteral("Image is empty");
+        return false;
+    }
+    const bool alpha = source.hasAlphaChannel();
+    const QImage image = source.convertToFormat(
+      alpha ? QImage::Format_RGBA8888 : QImage::Format_RGB888);
+    const int level = m_level == Z_DEFAULT_COMPRESSION ? 6 : m_level;
+
+    static const char signature[] = "\x89PNG\r\n\x1a\n";
+    if (m_device->write(signature, 8) != 8) {
+        m_error = m_device->errorString();
+        return false;
+    }
+
+    QByteArray header;
+    appendUint32(header, image.width());
+    appendUint32(header, image.height());
+    header.append(char(8));                 // bit depth
+    header.append(char(alpha ? 6 : 2));     // RGBA or RGB
+    header.append(3, char(0));              // compression, filter, interlace
+    if (!writeChunk("IHDR", { header })) {
+        return false;
+    }
+
+    if (image.dotsPerMeterX() > 0 && image.dotsPerMeterY() > 0) {
+        QByteArray physical;
+        appendUint32(physical, image.dotsPerMeterX());
+        appendUint32(physical, image.dotsPerMeterY());
+        physical.append(char(1)); // meters
+        if (!writeChunk("pHYs", { physical })) {
+            return false;
+        }
+    }
+
+    const int strips =
+      qBound(1, image.height() / minStripRows, QThread::idealThreadCount());
+    QVector<StripTask*> tasks;
+    QThreadPool pool;
+    pool.setMaxThreadCount(strips);
+    for (int i = 0; i < strips; ++i) {
+        int first = image.height() * i / strips;
+        int last = image.height() * (i + 1) / strips;
+        tasks.append(
+          new StripTask(image, first, last, level, m_filter, i == strips - 1));
+        pool.start(tasks.last());
+    }
+
+    // Each strip is written as soon as it and the ones before it are done,
+    // so the output starts while the next strips are still compressed
+    bool ok = true;
+    uLong adler = adler32(0, Z_NULL, 0);
+    for (int i = 0; i < strips && ok; ++i) {
+        StripTask* task = tasks[i];
+        task->waitForFinished();
+        if (!task->ok()) {
+            m_error = QStringLiteral("Compression failed");
+            ok = false;
+            break;
+        }
+        adler = adler32_combine(
+          adler, task->adler(), static_cast<z_off_t>(task->length()));
+
+        QList<QByteArray> parts;
+        if (i == 0) {
+            parts.append(QByteArray(1, char(0x78)) + zlibFlags(level));
+        }
+        parts.append(task->data());
+        if (i == strips - 1) {
+            QByteArray trailer;
+            appendUint32(trailer, adler);
+            parts.append(trailer);
+        }
+        ok = writeChunk("IDAT", parts);
+    }
+    pool.waitForDone();
+    qDeleteAll(tasks);
+
+    return ok && writeChunk("IEND", {});
+}
+
+QString PngEncoder::errorString() const
+{
+    return m_error;
+}
+
+/**
+ * @brief Write a chunk whose data is the concatenation of `parts`.
+ *
+ * The parts are written one after the other, so that the compressed strips
+ * don't have to be copied into a single buffer.
+ */
+bool PngEncoder::writeChunk(const char* type, const QList<QByteArray>& parts)
+{
+    QByteArray head;
+    quint32 size = 0;
+    for (const QByteArray& part : parts) {
+        size += part.size();
+    }
+    appendUint32(head, size);
+    head.append(type, 4);
+
+    uLong crc = crc32(0, reinterpret_cast<const Bytef*>(type), 4);
+    bool ok = m_device->write(head) == head.size();
+    for (const QByteArray& part : parts) {
+        crc = crc32(
+          crc, reinterpret_cast<const Bytef*>(part.constData()), part.size());
+        ok = ok && m_device->write(part) == part.size();
+    }
+    QByteArray tail;
+    appendUint32(tail, crc);
+    ok = ok && m_device->write(tail) == tail.size();
+    if (!ok) {
+        m_error = m_device->errorString();
+    }
+    return ok;
+}
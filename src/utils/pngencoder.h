@@ -0,0 +1,49 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include <QByteArray>
+#include <QImage>
+#include <QList>
+#include <QString>
+
+class QIODevice;
+
+/**
+ * @brief PNG encoder compressing horizontal strips of the image in parallel.
+ *
+ * Each strip is filtered and deflated on its own thread into a raw deflate
+ * stream that ends on a byte boundary (sync flush), so the strips can simply
+ * be concatenated into the zlib stream of the IDAT data. Their Adler-32
+ * checksums are combined for the stream trailer. The output is a regular
+ * PNG; only the compression ratio is marginally worse than a single stream
+ * since the strips don't share their dictionaries.
+ */
+class PngEncoder
+{
+public:
+    enum Filter
+    {
+        // Pick the best filter for each row, like libpng does
+        Adaptive,
+        // Always use the "Up" filter, which suits screenshots well enough
+        Fast
+    };
+
+    explicit PngEncoder(QIODevice* device);
+
+    void setCompressionLevel(int level);
+    void setFilter(Filter filter);
+
+    bool write(const QImage& image);
+    QString errorString() const;
+
+private:
+    bool writeChunk(const char* type, const QList<QByteArray>& parts);
+
+    QIODevice* m_device;
+    int m_level;
+    Filter m_filter;
+    QString m_error;
+};
@@ -0,0 +1,510 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "portalscreencast.h"
+#include "abstractlogger.h"
+#include "desktopstitcher.h"
+#include "request.h"
+#include <QDBusArgument>
+#include <QDBusInterface>
+#include <QDBusObjectPath>
+#include <QDBusReply>
+#include <QDBusUnixFileDescriptor>
+#include <QEventLoop>
+#include <QObject>
+#include <QUuid>
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <pipewire/pipewire.h>
+#include <spa/param/video/format-utils.h>
+
+/**
+ * @brief A monitor of the ScreenCast session and its PipeWire stream.
+ *
+ * Everything but `node` and `geometry` is only accessed with the thread loop
+ * locked.
+ */
+struct PortalScreencast::Stream
+{
+    uint32_t node = 0;
+    // Logical geometry of the monitor, as reported by the portal
+    QRect geometry;
+    pw_thread_loop* loop = nullptr;
+    pw_stream* stream = nullptr;
+    spa_hook listener = {};
+    spa_video_info_raw format = {};
+    // Latest frame, held back from the compositor until a newer one arrives
+    pw_buffer* current = nullptr;
+    bool failed = false;
+};
+
+namespace {
+
+const QString portalService = QStringLiteral("org.freedesktop.portal.Desktop");
+const QString portalPath = QStringLiteral("/org/freedesktop/portal/desktop");
+const QString screencastInterface =
+  QStringLiteral("org.freedesktop.portal.ScreenCast");
+
+// Source types and cursor modes of the ScreenCast portal
+const uint sourceMonitor = 1;
+const uint cursorHidden = 1;
+
+QString uniqueToken()
+{
+    return QUuid::createUuid().toString().remove('-').remove('{').remove('}');
+}
+
+QImage::Format imageFormat(uint32_t videoFormat)
+{
+    switch (videoFormat) {
+        case SPA_VIDEO_FORMAT_BGRx:
+            return QImage::Format_RGB32;
+        case SPA_VIDEO_FORMAT_BGRA:
+            return QImage::Format_ARGB32;
+        case SPA_VIDEO_FORMAT_RGBx:
+            return QImage::Format_RGBX8888;
+        case SPA_VIDEO_FORMAT_RGBA:
+            return QImage::Format_RGBA8888;
+        default:
+            return QImage::Format_Invalid;
+    }
+}
+
+void onStateChanged(void* data,
+                    pw_stream_state /*old*/,
+                    pw_stream_state state,
+                    const char* /*error*/)
+{
+    auto* stream = static_cast<PortalScreencast::Stream*>(data);
+    if (state == PW_STREAM_STATE_ERROR ||
+        state == PW_STREAM_STATE_UNCONNECTED) {
+        stream->failed = true;
+        pw_thread_loop_signal(stream->loop, false);
+    }
+}
+
+void onParamChanged(void* data, uint32_t id, const spa_pod* param)
+{
+    auto* stream = static_cast<PortalScreencast::Stream*>(data);
+    if (param == nullptr || id != SPA_PARAM_Format) {
+        return;
+    }
+    if (spa_format_video_raw_parse(param, &stream->format) < 0) {
+        return;
+    }
+
+    // One buffer is always kept back, so ask for enough of them that the
+    // compositor never runs out
+    uint8_t buffer[256];
+    spa_pod_builder builder = SPA_POD_BUILDER_INIT(buffer, sizeof(buffer));
+    const spa_pod* params[1];
+    params[0] = static_cast<const spa_pod*>(spa_pod_builder_add_object(
+      &builder,
+      SPA_TYPE_OBJECT_ParamBuffers,
+      SPA_PARAM_Buffers,
+      SPA_PARAM_BUFFERS_buffers,
+      SPA_POD_CHOICE_RANGE_Int(4, 2, 16),
+      SPA_PARAM_BUFFERS_dataType,
+      SPA_POD_CHOICE_FLAGS_Int((1 << SPA_DATA_MemPtr) |
+                               (1 << SPA_DATA_MemFd))));
+    pw_stream_update_params(stream->stream, params, 1);
+}
+
+void onProcess(void* data)
+{
+    auto* stream = static_cast<PortalScreencast::Stream*>(data);
+    pw_buffer* latest = nullptr;
+    pw_buffer* buffer;
+    while ((buffer = pw_stream_dequeue_buffer(stream->stream)) != nullptr) {
+        if (latest != nullptr) {
+            pw_stream_queue_buffer(stream->stream, latest);
+        }
+        latest = buffer;
+    }
+    if (latest == nullptr) {
+        return;
+    }
+    const spa_data& plane = latest->buffer->datas[0];
+    if (plane.data == nullptr || plane.chunk->size == 0) {
+        // Cursor or damage only update without new pixels
+        pw_stream_queue_buffer(stream->stream, latest);
+        return;
+    }
+    if (stream->current != nullptr) {
+        pw_stream_queue_buffer(stream->stream, stream->current);
+    }
+    stream->current = latest;
+    pw_thread_loop_signal(stream->loop, false);
+}
+
+pw_stream_events makeStreamEvents()
+{
+    pw_stream_events events = {};
+    events.version = PW_VERSION_STREAM_EVENTS;
+    events.state_changed = onStateChanged;
+    events.param_changed = onParamChanged;
+    events.process = onProcess;
+    return events;
+}
+
+const pw_stream_events streamEvents = makeStreamEvents();
+
+/**
+ * @brief Wrap the held frame of `stream` without copying it.
+ *
+ * The returned image is only valid as long as the thread loop stays locked.
+ */
+QImage frameImage(const PortalScreencast::Stream* stream)
+{
+    if (stream->current == nullptr) {
+        return {};
+    }
+    const spa_data& plane = stream->current->buffer->datas[0];
+    QImage::Format format = imageFormat(stream->format.format);
+    if (format == QImage::Format_Invalid) {
+        return {};
+    }
+    const auto* bits =
+      static_cast<const uchar*>(plane.data) + plane.chunk->offset;
+    return QImage(bits,
+                  static_cast<int>(stream->format.size.width),
+                  static_cast<int>(stream->format.size.height),
+                  plane.chunk->stride,
+                  format);
+}
+
+/**
+ * @brief Read a `(ii)` stream property, such as the position or the size.
+ */
+QPoint pairValue(const QVariantMap& properties, const QString& key)
+{
+    QPoint res;
+    if (properties.contains(key)) {
+        const auto argument = properties.value(key).value<QDBusArgument>();
+        argument.beginStructure();
+        argument >> res.rx() >> res.ry();
+        argument.endStructure();
+    }
+    return res;
+}
+
+QList<PortalScreencast::Stream*> parseStreams(const QVariant& streams)
+{
+    QList<PortalScreencast::Stream*> res;
+    const auto argument = streams.value<QDBusArgument>();
+    argument.beginArray();
+    while (!argument.atEnd()) {
+        auto* stream = new PortalScreencast::Stream();
+        QVariantMap properties;
+        argument.beginStructure();
+        argument >> stream->node >> properties;
+        argument.endStructure();
+
+        QPoint position = pairValue(properties, QStringLiteral("position"));
+        QPoint size = pairValue(properties, QStringLiteral("size"));
+        stream->geometry = QRect(position, QSize(size.x(), size.y()));
+        res.append(stream);
+    }
+    argument.endArray();
+    return res;
+}
+
+} // namespace
+
+PortalScreencast::PortalScreencast()
+  : m_loop(nullptr)
+  , m_context(nullptr)
+  , m_core(nullptr)
+{
+    pw_init(nullptr, nullptr);
+}
+
+PortalScreencast::~PortalScreencast()
+{
+    // The session bus may already be gone at exit, the portal closes the
+    // session along with the connection anyway
+    m_session.clear();
+    stop();
+}
+
+PortalScreencast* PortalScreencast::instance()
+{
+    static PortalScreencast c;
+    return &c;
+}
+
+/**
+ * @brief Capture `region` of the desktop from the latest frames.
+ * @param region Coordinates relative to the top left corner of the desktop,
+ * or a null rect for the entire desktop
+ * @return A null image if the session could not be started or was revoked
+ */
+QImage PortalScreencast::grab(const QRect& region)
+{
+    // A session revoked by the user is restarted once, which asks for
+    // permission again
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        if (m_loop == nullptr && !start()) {
+            return {};
+        }
+
+        pw_thread_loop_lock(m_loop);
+        bool failed = false;
+        for (Stream* stream : qAsConst(m_streams)) {
+            // Wait for the first frame after the session was started
+            while (!stream->failed && stream->current == nullptr) {
+                if (pw_thread_loop_timed_wait(m_loop, 2) != 0) {
+                    break;
+                }
+            }
+            failed = failed || stream->failed || stream->current == nullptr;
+        }
+        if (failed) {
+            pw_thread_loop_unlock(m_loop);
+            stop();
+            continue;
+        }
+
+        QRect desktop;
+        qreal scale = 1;
+        for (const Stream* stream : qAsConst(m_streams)) {
+            desktop = desktop.united(stream->geometry);
+            if (stream->geometry.width() > 0) {
+                scale = qMax(scale,
+                             static_cast<qreal>(stream->format.size.width) /
+                               stream->geometry.width());
+            }
+        }
+        QRect area = region.isNull() ? desktop.translated(-desktop.topLeft())
+                                     : region;
+
+        // The frames are copied while the loop is locked, so that the
+        // compositor can not reuse the buffers in the meantime
+        QImage res;
+        {
+            DesktopStitcher stitcher(area.size() * scale);
+            for (const Stream* stream : qAsConst(m_streams)) {
+                QRect part = stream->geometry.translated(-desktop.topLeft() -
+                                                         area.topLeft());
+                stitcher.add(frameImage(stream),
+                             DesktopStitcher::scaledRect(part, scale));
+            }
+            res = stitcher.result();
+        }
+        pw_thread_loop_unlock(m_loop);
+        return res;
+    }
+    return {};
+}
+
+/**
+ * @brief Open the ScreenCast session and connect to the monitor streams.
+ *
+ * This shows the permission dialog of the portal.
+ */
+bool PortalScreencast::start()
+{
+    QVariantMap results;
+    if (!request(QStringLiteral("CreateSession"),
+                 {},
+                 { { "session_handle_token", uniqueToken() } },
+                 results)) {
+        AbstractLogger::error()
+          << QObject::tr("Unable to create a screen cast session");
+        return false;
+    }
+    m_session = results.value(QStringLiteral("session_handle")).toString();
+    QDBusObjectPath session(m_session);
+
+    if (!request(QStringLiteral("SelectSources"),
+                 { QVariant::fromValue(session) },
+                 { { "types", sourceMonitor },
+                   { "multiple", true },
+                   { "cursor_mode", cursorHidden } },
+                 results) ||
+        !request(QStringLiteral("Start"),
+                 { QVariant::fromValue(session), QString() },
+                 {},
+                 results)) {
+        AbstractLogger::error()
+          << QObject::tr("The screen cast session was not allowed");
+        m_session.clear();
+        return false;
+    }
+    m_streams = parseStreams(results.value(QStringLiteral("streams")));
+
+    QDBusInterface screencast(portalService, portalPath, screencastInterface);
+    QDBusReply<QDBusUnixFileDescriptor> remote =
+      screencast.call(QStringLiteral("OpenPipeWireRemote"),
+                      QVariant::fromValue(session),
+                      QVariantMap());
+    if (!remote.isValid() || m_streams.isEmpty()) {
+        AbstractLogger::error()
+          << QObject::tr("Unable to open the PipeWire remote of the screen "
+                         "cast session");
+        stop();
+        return false;
+    }
+    // PipeWire takes ownership of the descriptor
+    int fd = fcntl(remote.value().fileDescriptor(), F_DUPFD_CLOEXEC, 3);
+    if (fd < 0) {
+        AbstractLogger::error()
+          << QObject::tr("Unable to open the PipeWire remote of the screen "
+                         "cast session") +
+               ": " + QString::fromLocal8Bit(strerror(errno));
+        stop();
+        return false;
+    }
+
+    m_loop = pw_thread_loop_new("flameshot-screencast", nullptr);
+    m_context =
+      pw_context_new(pw_thread_loop_get_loop(m_loop), nullptr, 0);
+    pw_thread_loop_start(m_loop);
+    pw_thread_loop_lock(m_loop);
+    m_core = pw_context_connect_fd(m_context, fd, nullptr, 0);
+    if (m_core == nullptr) {
+        pw_thread_loop_unlock(m_loop);
+        AbstractLogger::error()
+          << QObject::tr("Unable to connect to PipeWire");
+        stop();
+        return false;
+    }
+
+    spa_rectangle defaultSize = { 1920, 1080 };
+    spa_rectangle minSize = { 1, 1 };
+    spa_rectangle maxSize = { 16384, 16384 };
+    spa_fraction defaultRate = { 0, 1 };
+    spa_fraction minRate = { 0, 1 };
+    spa_fraction maxRate = { 240, 1 };
+    for (Stream* stream : qAsConst(m_streams)) {
+        uint8_t buffer[512];
+        spa_pod_builder builder = SPA_POD_BUILDER_INIT(buffer, sizeof(buffer));
+        const spa_pod* params[1];
+        params[0] = static_cast<const spa_pod*>(spa_pod_builder_add_object(
+          &builder,
+          SPA_TYPE_OBJECT_Format,
+          SPA_PARAM_EnumFormat,
+          SPA_FORMAT_mediaType,
+          SPA_POD_Id(SPA_MEDIA_TYPE_video),
+          SPA_FORMAT_mediaSubtype,
+          SPA_POD_Id(SPA_MEDIA_SUBTYPE_raw),
+          SPA_FORMAT_VIDEO_format,
+          SPA_POD_CHOICE_ENUM_Id(5,
+                                 SPA_VIDEO_FORMAT_BGRx,
+                                 SPA_VIDEO_FORMAT_BGRx,
+                                 SPA_VIDEO_FORMAT_BGRA,
+                                 SPA_VIDEO_FORMAT_RGBx,
+                                 SPA_VIDEO_FORMAT_RGBA),
+          SPA_FORMAT_VIDEO_size,
+          SPA_POD_CHOICE_RANGE_Rectangle(&defaultSize, &minSize, &maxSize),
+          SPA_FORMAT_VIDEO_framerate,
+          SPA_POD_CHOICE_RANGE_Fraction(&defaultRate, &minRate, &maxRate)));
+
+        stream->loop = m_loop;
+        stream->stream =
+          pw_stream_new(m_core,
+                        "flameshot",
+                        pw_properties_new(PW_KEY_MEDIA_TYPE,
+                                          "Video",
+                                          PW_KEY_MEDIA_CATEGORY,
+                                          "Capture",
+                                          PW_KEY_MEDIA_ROLE,
+                                          "Screen",
+                                          nullptr));
+        pw_stream_add_listener(
+          stream->stream, &stream->listener, &streamEvents, stream);
+        pw_stream_connect(stream->stream,
+                          PW_DIRECTION_INPUT,
+                          stream->node,
+                          static_cast<pw_stream_flags>(
+                            PW_STREAM_FLAG_AUTOCONNECT |
+                            PW_STREAM_FLAG_MAP_BUFFERS),
+                          params,
+                          1);
+    }
+    pw_thread_loop_unlock(m_loop);
+    return true;
+}
+
+/**
+ * @brief Disconnect the streams and close the session.
+ */
+void PortalScreencast::stop()
+{
+    if (m_loop != nullptr) {
+        pw_thread_loop_stop(m_loop);
+        for (Stream* stream : qAsConst(m_streams)) {
+            if (stream->stream != nullptr) {
+                pw_stream_destroy(stream->stream);
+            }
+        }
+        if (m_core != nullptr) {
+            pw_core_disconnect(m_core);
+        }
+        pw_context_destroy(m_context);
+        pw_thread_loop_destroy(m_loop);
+        m_core = nullptr;
+        m_context = nullptr;
+        m_loop = nullptr;
+    }
+    qDeleteAll(m_streams);
+    m_streams.clear();
+
+    if (!m_session.isEmpty()) {
+        QDBusMessage close = QDBusMessage::createMethodCall(
+          portalService,
+          m_session,
+          QStringLiteral("org.freedesktop.portal.Session"),
+          QStringLiteral("Close"));
+        QDBusConnection::sessionBus().call(close, QDBus::NoBlock);
+        m_session.clear();
+    }
+}
+
+/**
+ * @brief Call a method of the ScreenCast portal and wait for its response.
+ * @param results The results of the response
+ * @return false if the call failed or was cancelled by the user
+ */
+bool PortalScreencast::request(const QString& method,
+                               QList<QVariant> arguments,
+                               QVariantMap options,
+                               QVariantMap& results)
+{
+    QString token = uniqueToken();
+    options.insert(QStringLiteral("handle_token"), token);
+    arguments.append(options);
+
+    // listen before calling, the response may come before the reply
+    auto* request = new OrgFreedesktopPortalRequestInterface(
+      portalService,
+      "/org/freedesktop/portal/desktop/request/" +
+        QDBusConnection::sessionBus().baseService().remove(':').replace('.',
+                                                                        '_') +
+        "/" + token,
+      QDBusConnection::sessionBus());
+
+    QEventLoop loop;
+    uint response = 2;
+    QObject::connect(
+      request,
+      &org::freedesktop::portal::Request::Response,
+      [&](uint status, const QVariantMap& map) {
+          response = status;
+          results = map;
+          loop.quit();
+      });
+
+    QDBusInterface screencast(portalService, portalPath, screencastInterface);
+    QDBusMessage reply = screencast.callWithArgumentList(
+      QDBus::Block, method, arguments);
+    if (reply.type() == QDBusMessage::ErrorMessage) {
+        AbstractLogger::error() << reply.errorMessage();
+    } else {
+        loop.exec();
+    }
+    delete request;
+    return response == 0;
+}
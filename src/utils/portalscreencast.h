@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include <QImage>
+#include <QList>
+#include <QRect>
+#include <QString>
+#include <QVariant>
+
+struct pw_thread_loop;
+struct pw_context;
+struct pw_core;
+
+/**
+ * @brief Screen capture through a persistent xdg-desktop-portal ScreenCast
+ * session.
+ *
+ * The Screenshot portal asks for permission and writes a PNG to disk for
+ * every capture. Instead, a single ScreenCast session is opened the first
+ * time a capture is requested and kept for the lifetime of the process. The
+ * PipeWire streams of the monitors keep their latest frame, which is copied
+ * directly when a capture is taken, so repeated captures neither show the
+ * permission dialog again nor go through PNG encoding.
+ *
+ * @note Only used in the daemon process, the other ones capture through
+ * `FlameshotDaemon::grabScreencast`, or every command would open its own
+ * session and ask for permission again.
+ */
+class PortalScreencast
+{
+public:
+    struct Stream;
+
+    static PortalScreencast* instance();
+    ~PortalScreencast();
+
+    QImage grab(const QRect& region = QRect());
+
+private:
+    PortalScreencast();
+
+    bool start();
+    void stop();
+    bool request(const QString& method,
+                 QList<QVariant> arguments,
+                 QVariantMap options,
+                 QVariantMap& results);
+
+    QString m_session;
+    pw_thread_loop* m_loop;
+    pw_context* m_context;
+    pw_core* m_core;
+    QList<Stream*> m_streams;
+};
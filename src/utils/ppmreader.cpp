@@ -0,0 +1,119 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "ppmreader.h"
+#include <QIODevice>
+
+PpmReader::PpmReader()
+  : m_state(Header)
+  , m_inComment(false)
+  , m_row(0)
+  , m_column(0)
+  , m_rowBytes(0)
+{}
+
+/**
+ * @brief Consume the bytes that are currently available on the device.
+ * @return false if the stream is malformed
+ */
+bool PpmReader::read(QIODevice* device)
+{
+    if (m_state == Header && !parseHeader(device)) {
+        return m_state != Error;
+    }
+
+    while (m_state == Pixels) {
+        char* line = reinterpret_cast<char*>(m_image.scanLine(m_row));
+        qint64 count = device->read(line + m_column, m_rowBytes - m_column);
+        if (count < 0) {
+            m_state = Error;
+            break;
+        }
+        if (count == 0) {
+            break;
+        }
+        m_column += static_cast<int>(count);
+        if (m_column == m_rowBytes) {
+            m_column = 0;
+            if (++m_row == m_image.height()) {
+                m_state = Done;
+            }
+        }
+    }
+    return m_state != Error;
+}
+
+bool PpmReader::isComplete() const
+{
+    return m_state == Done;
+}
+
+bool PpmReader::hasError() const
+{
+    return m_state == Error;
+}
+
+QImage PpmReader::image() const
+{
+    return m_state == Done ? m_image : QImage();
+}
+
+/**
+ * @brief Read the header (magic, width, height, maxval) byte by byte.
+ * @return true once the header is complete and the image allocated
+ */
+bool PpmReader::parseHeader(QIODevice* device)
+{
+    char c;
+    while (device->getChar(&c)) {
+        if (m_inComment) {
+            m_inComment = c != '\n';
+            continue;
+        }
+        if (c == '#' && m_token.isEmpty()) {
+            m_inComment = true;
+            continue;
+        }
+        if (!QChar::isSpace(c)) {
+            m_token.append(c);
+            if (m_token.size() > 10) {
+                m_state = Error;
+                return false;
+            }
+            continue;
+        }
+        if (m_token.isEmpty()) {
+            continue;
+        }
+
+        if (m_fields.isEmpty() && m_token != "P6") {
+            // Only the binary RGB variant is produced by the grabbers
+            m_state = Error;
+            return false;
+        }
+        bool ok = true;
+        m_fields.append(m_fields.isEmpty() ? 6 : m_token.toInt(&ok));
+        m_token.clear();
+        if (!ok || m_fields.last() <= 0) {
+            m_state = Error;
+            return false;
+        }
+
+        if (m_fields.size() == 4) {
+            // The single whitespace after maxval has just been consumed
+            if (m_fields[3] != 255) {
+                m_state = Error;
+                return false;
+            }
+            m_image = QImage(m_fields[1], m_fields[2], QImage::Format_RGB888);
+            if (m_image.isNull()) {
+                m_state = Error;
+                return false;
+            }
+            m_rowBytes = m_fields[1] * 3;
+            m_state = Pixels;
+            return true;
+        }
+    }
+    return false;
+}
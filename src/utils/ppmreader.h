@@ -0,0 +1,49 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include <QByteArray>
+#include <QImage>
+#include <QList>
+
+class QIODevice;
+
+/**
+ * @brief Incremental reader for binary (P6) PPM streams.
+ *
+ * The image is allocated as soon as the header has been parsed and the pixel
+ * rows are read from the device straight into its scanlines, so a capture can
+ * be decoded while the producer is still writing it, without buffering the
+ * whole stream first.
+ */
+class PpmReader
+{
+public:
+    PpmReader();
+
+    bool read(QIODevice* device);
+    bool isComplete() const;
+    bool hasError() const;
+    QImage image() const;
+
+private:
+    enum State
+    {
+        Header,
+        Pixels,
+        Done,
+        Error
+    };
+
+    bool parseHeader(QIODevice* device);
+
+    State m_state;
+    QByteArray m_token;
+    QList<int> m_fields;
+    bool m_inComment;
+    QImage m_image;
+    int m_row;
+    int m_column;
+    int m_rowBytes;
+};
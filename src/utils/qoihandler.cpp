@@ -0,0 +1,266 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+// The plugin is compiled into the executable and registered with
+// Q_IMPORT_PLUGIN, which needs the static variant of the moc output
+#define QT_STATICPLUGIN
+
+#include "qoihandler.h"
+#include <QImage>
+#include <QIODevice>
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+
+const char qoiMagic[] = "qoif";
+const int headerSize = 14;
+const char endMarker[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+// The specification limits images to 400 million pixels
+const qint64 maxPixels = 400000000;
+// Encoded bytes are handed to the device in chunks of this size
+const int chunkSize = 64 * 1024;
+
+const quint8 opIndex = 0x00;
+const quint8 opDiff = 0x40;
+const quint8 opLuma = 0x80;
+const quint8 opRun = 0xc0;
+const quint8 opRgb = 0xfe;
+const quint8 opRgba = 0xff;
+const quint8 opMask = 0xc0;
+
+// Matches the byte order of QImage::Format_RGBA8888 and Format_RGBX8888
+struct Pixel
+{
+    quint8 r, g, b, a;
+};
+
+inline bool operator==(const Pixel& a, const Pixel& b)
+{
+    return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+inline int hash(const Pixel& px)
+{
+    return (px.r * 3 + px.g * 5 + px.b * 7 + px.a * 11) % 64;
+}
+
+} // namespace
+
+bool QoiHandler::canRead() const
+{
+    if (canRead(device())) {
+        setFormat("qoi");
+        return true;
+    }
+    return false;
+}
+
+bool QoiHandler::canRead(QIODevice* device)
+{
+    return device != nullptr && device->peek(4) == qoiMagic;
+}
+
+bool QoiHandler::read(QImage* image)
+{
+    QByteArray data = device()->readAll();
+    if (data.size() < headerSize + int(sizeof(endMarker)) ||
+        !data.startsWith(qoiMagic)) {
+        return false;
+    }
+    const auto* bytes = reinterpret_cast<const uchar*>(data.constData());
+    quint32 width = qFromBigEndian<quint32>(bytes + 4);
+    quint32 height = qFromBigEndian<quint32>(bytes + 8);
+    int channels = bytes[12];
+    if (width == 0 || height == 0 || (channels != 3 && channels != 4) ||
+        qint64(width) * height > maxPixels) {
+        return false;
+    }
+
+    QImage result(int(width),
+                  int(height),
+                  channels == 4 ? QImage::Format_RGBA8888
+                                : QImage::Format_RGBX8888);
+    if (result.isNull()) {
+        return false;
+    }
+
+    int pos = headerSize;
+    int end = data.size() - int(sizeof(endMarker));
+    Pixel index[64] = {};
+    Pixel px = { 0, 0, 0, 255 };
+    int run = 0;
+    for (int y = 0; y < result.height(); ++y) {
+        auto* line = reinterpret_cast<Pixel*>(result.scanLine(y));
+        for (int x = 0; x < result.width(); ++x) {
+            if (run > 0) {
+                --run;
+                line[x] = px;
+                continue;
+            }
+            if (pos >= end) {
+                return false;
+            }
+            quint8 b1 = bytes[pos++];
+            if (b1 == opRgb || b1 == opRgba) {
+                int size = b1 == opRgb ? 3 : 4;
+                if (pos + size > end) {
+                    return false;
+                }
+                px.r = bytes[pos];
+                px.g = bytes[pos + 1];
+                px.b = bytes[pos + 2];
+                if (b1 == opRgba) {
+                    px.a = bytes[pos + 3];
+                }
+                pos += size;
+            } else if ((b1 & opMask) == opIndex) {
+                px = index[b1];
+            } else if ((b1 & opMask) == opDiff) {
+                px.r += ((b1 >> 4) & 0x03) - 2;
+                px.g += ((b1 >> 2) & 0x03) - 2;
+                px.b += (b1 & 0x03) - 2;
+            } else if ((b1 & opMask) == opLuma) {
+                if (pos >= end) {
+                    return false;
+                }
+                quint8 b2 = bytes[pos++];
+                int vg = (b1 & 0x3f) - 32;
+                px.r += vg - 8 + ((b2 >> 4) & 0x0f);
+                px.g += vg;
+                px.b += vg - 8 + (b2 & 0x0f);
+            } else {
+                run = b1 & 0x3f;
+            }
+            index[hash(px)] = px;
+            line[x] = px;
+        }
+    }
+
+    *image = result;
+    return true;
+}
+
+bool QoiHandler::write(const QImage& image)
+{
+    bool alpha = image.hasAlphaChannel();
+    QImage source = image.convertToFormat(
+      alpha ? QImage::Format_RGBA8888 : QImage::Format_RGBX8888);
+    if (source.isNull()) {
+        return false;
+    }
+
+    char header[headerSize];
+    memcpy(header, qoiMagic, 4);
+    qToBigEndian<quint32>(source.width(), header + 4);
+    qToBigEndian<quint32>(source.height(), header + 8);
+    header[12] = alpha ? 4 : 3;
+    header[13] = 0; // sRGB with linear alpha
+    if (device()->write(header, headerSize) != headerSize) {
+        return false;
+    }
+
+    QByteArray chunk;
+    // A single pixel takes at most 5 bytes
+    chunk.reserve(chunkSize + 5 * source.width());
+    Pixel index[64] = {};
+    Pixel prev = { 0, 0, 0, 255 };
+    int run = 0;
+    for (int y = 0; y < source.height(); ++y) {
+        const auto* line =
+          reinterpret_cast<const Pixel*>(source.constScanLine(y));
+        for (int x = 0; x < source.width(); ++x) {
+            const Pixel& px = line[x];
+            if (px == prev) {
+                // Runs may continue on the next row
+                if (++run == 62) {
+                    chunk.append(char(opRun | (run - 1)));
+                    run = 0;
+                }
+                continue;
+            }
+            if (run > 0) {
+                chunk.append(char(opRun | (run - 1)));
+                run = 0;
+            }
+
+            int h = hash(px);
+            if (index[h] == px) {
+                chunk.append(char(opIndex | h));
+            } else if (px.a != prev.a) {
+                index[h] = px;
+                const char op[] = {
+                    char(opRgba), char(px.r), char(px.g), char(px.b),
+                    char(px.a)
+                };
+                chunk.append(op, sizeof(op));
+            } else {
+                index[h] = px;
+                auto vr = qint8(px.r - prev.r);
+                auto vg = qint8(px.g - prev.g);
+                auto vb = qint8(px.b - prev.b);
+                int vgR = vr - vg;
+                int vgB = vb - vg;
+                if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 &&
+                    vb < 2) {
+                    chunk.append(
+                      char(opDiff | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2)));
+                } else if (vgR > -9 && vgR < 8 && vg > -33 && vg < 32 &&
+                           vgB > -9 && vgB < 8) {
+                    chunk.append(char(opLuma | (vg + 32)));
+                    chunk.append(char((vgR + 8) << 4 | (vgB + 8)));
+                } else {
+                    const char op[] = {
+                        char(opRgb), char(px.r), char(px.g), char(px.b)
+                    };
+                    chunk.append(op, sizeof(op));
+                }
+            }
+            prev = px;
+        }
+
+        if (chunk.size() >= chunkSize) {
+            if (device()->write(chunk) != chunk.size()) {
+                return false;
+            }
+            chunk.resize(0);
+        }
+    }
+    if (run > 0) {
+        chunk.append(char(opRun | (run - 1)));
+    }
+    chunk.append(endMarker, sizeof(endMarker));
+    return device()->write(chunk) == chunk.size();
+}
+
+QImageIOPlugin::Capabilities QoiPlugin::capabilities(
+  QIODevice* device,
+  const QByteArray& format) const
+{
+    if (format == "qoi") {
+        return Capabilities(CanRead | CanWrite);
+    }
+    if (!format.isEmpty() || device == nullptr || !device->isOpen()) {
+        return {};
+    }
+
+    Capabilities caps;
+    if (device->isReadable() && QoiHandler::canRead(device)) {
+        caps |= CanRead;
+    }
+    if (device->isWritable()) {
+        caps |= CanWrite;
+    }
+    return caps;
+}
+
+QImageIOHandler* QoiPlugin::create(QIODevice* device,
+                                   const QByteArray& format) const
+{
+    auto* handler = new QoiHandler();
+    handler->setDevice(device);
+    handler->setFormat(format);
+    return handler;
+}
+
+#include "moc_qoihandler.cpp"
@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include <QImageIOHandler>
+#include <QImageIOPlugin>
+
+/**
+ * @brief Reader and writer for the QOI ("Quite OK Image") format.
+ *
+ * QOI is lossless and encodes in a single pass without any entropy coding,
+ * which makes it much faster than PNG on screenshots while the flat colors
+ * still compress well.
+ *
+ * @see https://qoiformat.org/qoi-specification.pdf
+ */
+class QoiHandler : public QImageIOHandler
+{
+public:
+    bool canRead() const override;
+    bool read(QImage* image) override;
+    bool write(const QImage& image) override;
+
+    static bool canRead(QIODevice* device);
+};
+
+/**
+ * @brief Registers `QoiHandler` for the "qoi" format.
+ *
+ * The plugin is linked statically into flameshot (see `Q_IMPORT_PLUGIN` in
+ * main.cpp), so `QImageReader`, `QImageWriter` and everything built on top of
+ * them support QOI without installing a Qt image format plugin.
+ */
+class QoiPlugin : public QImageIOPlugin
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID QImageIOHandlerFactoryInterface_iid FILE "qoi.json")
+
+public:
+    Capabilities capabilities(QIODevice* device,
+                              const QByteArray& format) const override;
+    QImageIOHandler* create(
+      QIODevice* device,
+      const QByteArray& format = QByteArray()) const override;
+};
@@ -3,6 +3,7 @@
 
 #include "screengrabber.h"
 #include "abstractlogger.h"
+#include "ppmreader.h"
 #include "src/core/qguiappcurrentscreen.h"
 #include "src/utils/filenamehandler.h"
 #include "src/utils/systemnotification.h"
@@ -22,22 +23,67 @@
 #include <QUuid>
 #endif
 
+#ifdef USE_WAYLAND_SCREENCOPY
+#include "src/utils/waylandscreencopy.h"
+#endif
+
+#ifdef USE_PORTAL_SCREENCAST
+#include "src/core/flameshotdaemon.h"
+#endif
+
 ScreenGrabber::ScreenGrabber(QObject* parent)
   : QObject(parent)
 {}
 
-void ScreenGrabber::generalGrimScreenshot(bool& ok, QPixmap& res)
+void ScreenGrabber::generalGrimScreenshot(bool& ok,
+                                          QPixmap& res,
+                                          const QRect& region)
 {
 #ifdef USE_WAYLAND_GRIM
 #if defined(Q_OS_LINUX) || defined(Q_OS_UNIX)
     QProcess Process;
     QString program = "grim";
     QStringList arguments;
+    // Uncompressed output, decoded while grim is still writing it
+    arguments << "-t"
+              << "ppm";
+    if (!region.isNull()) {
+        // Let grim transfer only the requested output or region. The region
+        // is relative to the desktop, grim expects layout coordinates.
+        QRect geometry = region.translated(desktopGeometry().topLeft());
+        QScreen* output = nullptr;
+        for (QScreen* const screen : QGuiApplication::screens()) {
+            if (screen->geometry() == geometry) {
+                output = screen;
+                break;
+            }
+        }
+        if (output != nullptr && !output->name().isEmpty()) {
+            arguments << "-o" << output->name();
+        } else {
+            arguments << "-g"
+                      << QStringLiteral("%1,%2 %3x%4")
+                           .arg(geometry.x())
+                           .arg(geometry.y())
+                           .arg(geometry.width())
+                           .arg(geometry.height());
+        }
+    }
     arguments << "-";
     Process.start(program, arguments);
-    if (Process.waitForFinished()) {
-        res.loadFromData(Process.readAll());
-        ok = true;
+    if (Process.waitForStarted()) {
+        PpmReader reader;
+        while (reader.read(&Process) && !reader.isComplete() &&
+               Process.waitForReadyRead()) {
+        }
+        Process.waitForFinished();
+        reader.read(&Process);
+        ok = reader.isComplete();
+        if (ok) {
+            res = QPixmap::fromImage(reader.image());
+        } else {
+            AbstractLogger::error() << tr("Unable to read the grim output");
+        }
     } else {
         ok = false;
         AbstractLogger::error()
@@ -49,6 +95,46 @@ void ScreenGrabber::generalGrimScreenshot(bool& ok, QPixmap& res)
 #endif
 }
 
+void ScreenGrabber::waylandScreencopy(bool& ok,
+                                      QPixmap& res,
+                                      const QRect& region)
+{
+    ok = false;
+#ifdef USE_WAYLAND_SCREENCOPY
+    WaylandScreencopy screencopy;
+    if (!screencopy.isAvailable()) {
+        AbstractLogger::warning()
+          << tr("The compositor does not support the wlroots screencopy "
+                "protocol");
+        return;
+    }
+    QImage image = region.isNull()
+                     ? screencopy.grabDesktop()
+                     : screencopy.grabRegion(
+                         region.translated(desktopGeometry().topLeft()));
+    if (!image.isNull()) {
+        res = QPixmap::fromImage(std::move(image));
+        ok = true;
+    }
+#endif
+}
+
+void ScreenGrabber::portalScreencast(bool& ok,
+                                     QPixmap& res,
+                                     const QRect& region)
+{
+    ok = false;
+#ifdef USE_PORTAL_SCREENCAST
+    // Hosted by the daemon, even for captures of the command line
+    QImage image = FlameshotDaemon::grabScreencast(region);
+    if (!image.isNull()) {
+        res = QPixmap::fromImage(std::move(image));
+        res.setDevicePixelRatio(qApp->devicePixelRatio());
+        ok = true;
+    }
+#endif
+}
+
 void ScreenGrabber::freeDesktopPortal(bool& ok, QPixmap& res)
 {
 
@@ -121,48 +207,7 @@ QPixmap ScreenGrabber::grabEntireDesktop(bool& ok)
     return screenPixmap;
 #elif defined(Q_OS_LINUX) || defined(Q_OS_UNIX)
     if (m_info.waylandDetected()) {
-        QPixmap res;
-        // handle screenshot based on DE
-        switch (m_info.windowManager()) {
-            case DesktopInfo::GNOME:
-            case DesktopInfo::KDE:
-                freeDesktopPortal(ok, res);
-                break;
-            case DesktopInfo::QTILE:
-            case DesktopInfo::SWAY:
-            case DesktopInfo::HYPRLAND:
-            case DesktopInfo::OTHER: {
-#ifndef USE_WAYLAND_GRIM
-                AbstractLogger::warning() << tr(
-                  "If the USE_WAYLAND_GRIM option is not activated, the dbus "
-                  "protocol will be used. It should be noted that using the "
-                  "dbus protocol under wayland is not recommended. It is "
-                  "recommended to recompile with the USE_WAYLAND_GRIM flag to "
-                  "activate the grim-based general wayland screenshot adapter");
-                freeDesktopPortal(ok, res);
-#else
-                AbstractLogger::warning()
-                  << tr("grim's screenshot component is implemented based on "
-                        "wlroots, it may not be used in GNOME or similar "
-                        "desktop environments");
-                generalGrimScreenshot(ok, res);
-#endif
-                break;
-            }
-            default:
-                ok = false;
-                AbstractLogger::error()
-                  << tr("Unable to detect desktop environment (GNOME? KDE? "
-                        "Qile? Sway? ...)");
-                AbstractLogger::error()
-                  << tr("Hint: try setting the XDG_CURRENT_DESKTOP environment "
-                        "variable.");
-                break;
-        }
-        if (!ok) {
-            AbstractLogger::error() << tr("Unable to capture screen");
-        }
-        return res;
+        return grabWayland(QRect(), ok);
     }
 #endif
 #if defined(Q_OS_LINUX) || defined(Q_OS_UNIX) || defined(Q_OS_WIN)
@@ -180,6 +225,119 @@ QPixmap ScreenGrabber::grabEntireDesktop(bool& ok)
 #endif
 }
 
+/**
+ * @brief Capture only `region` of the desktop.
+ * @param region Coordinates relative to the top left corner of the desktop,
+ * as used by the `--region` option
+ */
+QPixmap ScreenGrabber::grabRegion(const QRect& region, bool& ok)
+{
+    ok = true;
+#if defined(Q_OS_MACOS)
+    QPixmap p = grabEntireDesktop(ok);
+    return ok ? p.copy(region) : p;
+#else
+#if defined(Q_OS_LINUX) || defined(Q_OS_UNIX)
+    if (m_info.waylandDetected()) {
+        return grabWayland(region, ok);
+    }
+#endif
+    QRect geometry = region.translated(desktopGeometry().topLeft());
+    QPixmap p(QApplication::primaryScreen()->grabWindow(
+      QApplication::desktop()->winId(),
+      geometry.x(),
+      geometry.y(),
+      geometry.width(),
+      geometry.height()));
+    auto screenNumber = QApplication::desktop()->screenNumber();
+    QScreen* screen = QApplication::screens()[screenNumber];
+    p.setDevicePixelRatio(screen->devicePixelRatio());
+    return p;
+#endif
+}
+
+/**
+ * @brief Capture on Wayland, choosing the backend based on the compositor.
+ * @param region Part of the desktop to capture in logical coordinates
+ * relative to its top left corner (as for `grabRegion`), or a null rect for
+ * the entire desktop. Backends that support it only transfer the pixels of
+ * the region.
+ */
+QPixmap ScreenGrabber::grabWayland(const QRect& region, bool& ok)
+{
+    ok = true;
+#if defined(Q_OS_LINUX) || defined(Q_OS_UNIX)
+    QPixmap res;
+    // handle screenshot based on DE
+    switch (m_info.windowManager()) {
+        case DesktopInfo::GNOME:
+        case DesktopInfo::KDE:
+#ifdef USE_PORTAL_SCREENCAST
+            // Persistent session, falling back to the screenshot portal
+            portalScreencast(ok, res, region);
+            if (ok) {
+                break;
+            }
+            ok = true;
+#endif
+            // The portal always captures the whole desktop
+            freeDesktopPortal(ok, res);
+            if (ok && !region.isNull()) {
+                res = res.copy(region);
+            }
+            break;
+        case DesktopInfo::QTILE:
+        case DesktopInfo::SWAY:
+        case DesktopInfo::HYPRLAND:
+        case DesktopInfo::OTHER: {
+#ifdef USE_WAYLAND_SCREENCOPY
+            // Native capture, falling back to grim or the portal below
+            waylandScreencopy(ok, res, region);
+            if (ok) {
+                break;
+            }
+            ok = true;
+#endif
+#ifndef USE_WAYLAND_GRIM
+            AbstractLogger::warning() << tr(
+              "If the USE_WAYLAND_GRIM option is not activated, the dbus "
+              "protocol will be used. It should be noted that using the "
+              "dbus protocol under wayland is not recommended. It is "
+              "recommended to recompile with the USE_WAYLAND_GRIM flag to "
+              "activate the grim-based general wayland screenshot adapter");
+            freeDesktopPortal(ok, res);
+            if (ok && !region.isNull()) {
+                res = res.copy(region);
+            }
+#else
+            AbstractLogger::warning()
+              << tr("grim's screenshot component is implemented based on "
+                    "wlroots, it may not be used in GNOME or similar "
+                    "desktop environments");
+            generalGrimScreenshot(ok, res, region);
+#endif
+            break;
+        }
+        default:
+            ok = false;
+            AbstractLogger::error()
+              << tr("Unable to detect desktop environment (GNOME? KDE? "
+                    "Qile? Sway? ...)");
+            AbstractLogger::error()
+              << tr("Hint: try setting the XDG_CURRENT_DESKTOP environment "
+                    "variable.");
+            break;
+    }
+    if (!ok) {
+        AbstractLogger::error() << tr("Unable to capture screen");
+    }
+    return res;
+#else
+    ok = false;
+    return {};
+#endif
+}
+
 QRect ScreenGrabber::screenGeometry(QScreen* screen)
 {
     QPixmap p;
@@ -209,10 +367,7 @@ QPixmap ScreenGrabber::grabScreen(QScreen* screen, bool& ok)
     QPixmap p;
     QRect geometry = screenGeometry(screen);
     if (m_info.waylandDetected()) {
-        p = grabEntireDesktop(ok);
-        if (ok) {
-            return p.copy(geometry);
-        }
+        p = grabWayland(geometry.translated(-desktopGeometry().topLeft()), ok);
     } else {
         ok = true;
         return screen->grabWindow(QApplication::desktop()->winId(),
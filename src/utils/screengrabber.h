@@ -13,12 +13,23 @@ class ScreenGrabber : public QObject
 public:
     explicit ScreenGrabber(QObject* parent = nullptr);
     QPixmap grabEntireDesktop(bool& ok);
+    QPixmap grabRegion(const QRect& region, bool& ok);
     QRect screenGeometry(QScreen* screen);
     QPixmap grabScreen(QScreen* screenNumber, bool& ok);
     void freeDesktopPortal(bool& ok, QPixmap& res);
-    void generalGrimScreenshot(bool& ok, QPixmap& res);
+    void portalScreencast(bool& ok,
+                          QPixmap& res,
+                          const QRect& region = QRect());
+    void generalGrimScreenshot(bool& ok,
+                               QPixmap& res,
+                               const QRect& region = QRect());
+    void waylandScreencopy(bool& ok,
+                           QPixmap& res,
+                           const QRect& region = QRect());
     QRect desktopGeometry();
 
 private:
+    QPixmap grabWayland(const QRect& region, bool& ok);
+
     DesktopInfo m_info;
 };
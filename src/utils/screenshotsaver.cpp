@@ -3,11 +3,14 @@
 
 #include "screenshotsaver.h"
 #include "abstractlogger.h"
+#include "src/core/exportqueue.h"
 #include "src/core/flameshot.h"
 #include "src/core/flameshotdaemon.h"
+#include "src/utils/atomicfilesaver.h"
 #include "src/utils/confighandler.h"
 #include "src/utils/filenamehandler.h"
 #include "src/utils/globalvalues.h"
+#include "src/utils/imagemimedata.h"
 #include "utils/desktopinfo.h"
 
 #if USE_WAYLAND_CLIPBOARD
@@ -15,11 +18,13 @@
 #endif
 
 #include <QApplication>
-#include <QBuffer>
 #include <QClipboard>
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QMimeData>
+#include <QPointer>
+#include <QSaveFile>
+#include <QSharedPointer>
 #include <QStandardPaths>
 #include <qimagewriter.h>
 #include <qmimedatabase.h>
@@ -28,51 +33,72 @@
 #endif
 
 #if USE_WL_COPY
-#include <array>
-#include <unistd.h>
-#include <fcntl.h>
-#include <wait.h>
+#include "src/utils/wlcopysink.h"
 #endif
 
-bool saveToFilesystem(const QPixmap& capture,
-                      const QString& path,
-                      const QString& messagePrefix)
+/**
+ * @brief The format a capture is saved to `path` in: its extension, or an
+ * indexed PNG if enabled for saved files.
+ */
+QString saveFormat(const QString& path)
 {
-    QString completePath = FileNameHandler().properScreenshotPath(
-      path, ConfigHandler().saveAsFileExtension());
-    QFile file{ completePath };
-    file.open(QIODevice::WriteOnly);
-
-    bool okay;
-    QString saveExtension;
-    saveExtension = QFileInfo(completePath).suffix().toLower();
-    if (saveExtension == "jpg" || saveExtension == "jpeg") {
-        okay = capture.save(&file, nullptr, ConfigHandler().jpegQuality());
-    } else {
-        okay = capture.save(&file);
-    }
-
-    QString saveMessage = messagePrefix;
-    QString notificationPath = completePath;
-    if (!saveMessage.isEmpty()) {
-        saveMessage += " ";
+    QString format = QFileInfo(path).suffix();
+    if (format.compare("png", Qt::CaseInsensitive) == 0 &&
+        ConfigHandler().indexedPngForSave()) {
+        return QStringLiteral("png8");
     }
+    return format;
+}
 
-    if (okay) {
-        saveMessage += QObject::tr("Capture saved as ") + completePath;
-        AbstractLogger::info().attachNotificationPath(notificationPath)
-          << saveMessage;
-    } else {
-        saveMessage += QObject::tr("Error trying to save as ") + completePath;
-        if (file.error() != QFile::NoError) {
-            saveMessage += ": " + file.errorString();
-        }
-        notificationPath = "";
-        AbstractLogger::error().attachNotificationPath(notificationPath)
-          << saveMessage;
+/**
+ * @brief Write the capture to `file`, encoded as indicated by its extension.
+ */
+static bool writeCapture(QSaveFile& file, const EncodedCapture& capture)
+{
+    if (!capture.write(&file, saveFormat(file.fileName()))) {
+        file.cancelWriting();
+        return false;
     }
+    return file.commit();
+}
 
-    return okay;
+void saveToFilesystem(const EncodedCapture& capture,
+                      const QString& path,
+                      const QString& messagePrefix)
+{
+    // Only the name, the saver takes the first free "_NUM" variant of it
+    // once the file is written
+    QString completePath = FileNameHandler().completePath(
+      path, ConfigHandler().saveAsFileExtension());
+    // Converted here, the export thread must not touch the pixmap
+    capture.image();
+
+    AtomicFileSaver::save(
+      capture,
+      completePath,
+      saveFormat(completePath),
+      [completePath, messagePrefix](const AtomicFileSaver::Result& result) {
+          QString saveMessage = messagePrefix;
+          QString notificationPath = result.path;
+          if (!saveMessage.isEmpty()) {
+              saveMessage += " ";
+          }
+
+          if (result.ok) {
+              saveMessage += QObject::tr("Capture saved as ") + result.path;
+              AbstractLogger::info().attachNotificationPath(notificationPath)
+                << saveMessage;
+          } else {
+              saveMessage +=
+                QObject::tr("Error trying to save as ") + completePath;
+              if (!result.error.isEmpty()) {
+                  saveMessage += ": " + result.error;
+              }
+              notificationPath = "";
+              AbstractLogger::error().attachNotificationPath(notificationPath)
+                << saveMessage;
+          }
+      });
 }
 
 QString ShowSaveFileDialog(const QString& title, const QString& directory)
@@ -81,25 +107,46 @@ QString ShowSaveFileDialog(const QString& title, const QString& directory)
     dialog.setAcceptMode(QFileDialog::AcceptSave);
 
     // Build string list of supported image formats
-    QStringList mimeTypeList;
+    QMimeDatabase mimeDatabase;
+    QStringList mimeTypeList, extraFilters;
     foreach (auto mimeType, QImageWriter::supportedMimeTypes()) {
         // image/heif has several aliases and they cause glitch in save dialog
         // It is necessary to keep the image/heif (otherwise HEIF plug-in from
         // kimageformats will not work) but the aliases could be filtered out.
-        if (mimeType != "image/heic" && mimeType != "image/heic-sequence" &&
-            mimeType != "image/heif-sequence") {
+        if (mimeType == "image/heic" || mimeType == "image/heic-sequence" ||
+            mimeType == "image/heif-sequence") {
+            continue;
+        }
+        if (mimeDatabase.mimeTypeForName(mimeType).isValid()) {
             mimeTypeList.append(mimeType);
+        } else {
+            // Older shared-mime-info releases do not know e.g. image/qoi,
+            // which the dialog would silently drop
+            QString suffix = QString(mimeType).section('/', 1);
+            extraFilters.append(QObject::tr("%1 image (*.%2)")
+                                  .arg(suffix.toUpper(), suffix));
         }
     }
     dialog.setMimeTypeFilters(mimeTypeList);
+    if (!extraFilters.isEmpty()) {
+        dialog.setNameFilters(dialog.nameFilters() + extraFilters);
+    }
 
     QString suffix = ConfigHandler().saveAsFileExtension();
     if (suffix.isEmpty()) {
         suffix = "png";
     }
     QString defaultMimeType =
-      QMimeDatabase().mimeTypeForFile("image." + suffix).name();
-    dialog.selectMimeTypeFilter(defaultMimeType);
+      mimeDatabase.mimeTypeForFile("image." + suffix).name();
+    if (mimeTypeList.contains(defaultMimeType)) {
+        dialog.selectMimeTypeFilter(defaultMimeType);
+    } else {
+        for (const QString& filter : qAsConst(extraFilters)) {
+            if (filter.endsWith("(*." + suffix + ")")) {
+                dialog.selectNameFilter(filter);
+            }
+        }
+    }
     dialog.setDefaultSuffix(suffix);
     if (dialog.exec() == QDialog::Accepted) {
         return dialog.selectedFiles().constFirst();
@@ -108,87 +155,80 @@ QString ShowSaveFileDialog(const QString& title, const QString& directory)
     }
 }
 
-static void logErr(std::string const &name) {
-    constexpr size_t ERRBUF_LEN = 64;
-
-    std::array<char, ERRBUF_LEN> errbuf {};
-    strerror_r(errno, errbuf.data(), errbuf.size());
-    AbstractLogger::error() << ("wl_copy: " + name + ": ").data() << errbuf.data();
-}
-
-static void saveToClipboardWlCopy(const QByteArray& array, const QString& imageType) {
-    if (imageType != "png") {
-        AbstractLogger::error() << "WL_COPY option only supports png";
+#if USE_WL_COPY
+static void saveToClipboardWlCopy(const EncodedCapture& capture,
+                                  const QString& imageType)
+{
+    // Created first so that it drains its jobs before the sink below is
+    // flushed when quitting
+    ExportQueue* queue = ExportQueue::instance();
+    // wl-copy starts right away and receives the image while it is being
+    // encoded, the data is written to it while the event loop runs
+    QPointer<WlCopySink> sink = WlCopySink::start("image/" + imageType);
+    if (sink == nullptr) {
+        AbstractLogger::error()
+          << QObject::tr("Error while saving to clipboard");
         return;
     }
 
-    std::array<int, 2> pipefds {};
-    if (pipe2(pipefds.data(), O_CLOEXEC) == -1) {
-        logErr("pipe2");
-    }
-
-    int pid = fork();
-    if (pid == -1) {
-        logErr("fork");
-    }
-    if (pid == 0) {
-        // child, close input fd
-        close(pipefds[1]);
-        if (dup2(pipefds[0], STDIN_FILENO) == -1) {
-            logErr("dup2");
-        }
-        close(pipefds[0]);
-        execlp("wl-copy", "wl-copy", "-t", "image/png", NULL);
-    }
-
-    close(pipefds[0]);
-    write(pipefds[1], array.data(), array.size());
-    close(pipefds[1]);
-    waitpid(pid, nullptr, 0);
+    // Converted here, the export thread must not touch the pixmap
+    capture.image();
+    QString format =
+      imageType == "png" && ConfigHandler().indexedPngForClipboard()
+        ? QStringLiteral("png8")
+        : imageType;
+    auto ok = QSharedPointer<bool>::create(false);
+    queue->enqueue(
+      [capture, format, sink, ok]() {
+          WlCopyDevice device(sink);
+          device.open(QIODevice::WriteOnly);
+          *ok = capture.write(&device, format);
+          device.finish(*ok);
+      },
+      [capture, ok]() {
+          if (!*ok) {
+              AbstractLogger::error()
+                << QObject::tr("Error while saving to clipboard") + ": " +
+                     capture.errorString();
+          }
+      });
 }
+#endif
 
-void saveToClipboardMime(const QPixmap& capture, const QString& imageType)
+/**
+ * @brief The format `saveToClipboard` copies a capture in first.
+ */
+QString clipboardFormat()
 {
-    QByteArray array;
-    QBuffer buffer{ &array };
-    QImageWriter imageWriter{ &buffer, imageType.toUpper().toUtf8() };
-    if (imageType == "jpeg") {
-        imageWriter.setQuality(ConfigHandler().jpegQuality());
+    ConfigHandler config;
+    if (config.useJpgForClipboard()) {
+        return QStringLiteral("jpeg");
     }
-    imageWriter.write(capture.toImage());
-
-    QPixmap formattedPixmap;
-    bool isLoaded =
-      formattedPixmap.loadFromData(reinterpret_cast<uchar*>(array.data()),
-                                   array.size(),
-                                   imageType.toUpper().toUtf8());
-    if (isLoaded) {
-        auto* mimeData = new QMimeData();
+    return config.indexedPngForClipboard() ? QStringLiteral("png8")
+                                           : QStringLiteral("png");
+}
 
+void saveToClipboardMime(const EncodedCapture& capture,
+                         const QString& imageType)
+{
 #ifdef USE_WL_COPY
-        auto *bytes = array.data();
-        saveToClipboardWlCopy(array, imageType);
-#elif defined(USE_WAYLAND_CLIPBOARD)
-        AbstractLogger::info() << "wl_wayland_copy";
-        mimeData->setImageData(formattedPixmap.toImage());
-        mimeData->setData(QStringLiteral("x-kde-force-image-copy"),
-                          QByteArray());
-        KSystemClipboard::instance()->setMimeData(mimeData,
-                                                  QClipboard::Clipboard);
+    saveToClipboardWlCopy(capture, imageType);
 #else
-        mimeData->setData("image/" + imageType, array);
-        QApplication::clipboard()->setMimeData(mimeData);
+    // Encoded only once a client pastes it
+    auto* mimeData = new ImageMimeData(capture, imageType);
+#if defined(USE_WAYLAND_CLIPBOARD)
+    AbstractLogger::info() << "wl_wayland_copy";
+    mimeData->setData(QStringLiteral("x-kde-force-image-copy"), QByteArray());
+    KSystemClipboard::instance()->setMimeData(mimeData, QClipboard::Clipboard);
+#else
+    QApplication::clipboard()->setMimeData(mimeData);
+#endif
 #endif
-
-    } else {
-        AbstractLogger::error()
-          << QObject::tr("Error while saving to clipboard");
-    }
 }
 
 // If data is saved to the clipboard before the notification is sent via
 // dbus, the application freezes.
-void saveToClipboard(const QPixmap& capture)
+void saveToClipboard(const EncodedCapture& capture)
 {
     // If we are able to properly save the file, save the file and copy to
     // clipboard.
@@ -209,15 +249,16 @@ void saveToClipboard(const QPixmap& capture)
         if (DesktopInfo().waylandDetected()) {
             saveToClipboardMime(capture, "png");
         } else {
-            QApplication::clipboard()->setPixmap(capture);
+            QApplication::clipboard()->setMimeData(
+              new ImageMimeData(capture));
         }
 #else
-        QApplication::clipboard()->setPixmap(capture);
+        QApplication::clipboard()->setPixmap(capture.pixmap());
 #endif
     }
 }
 
-bool saveToFilesystemGUI(const QPixmap& capture)
+bool saveToFilesystemGUI(const EncodedCapture& capture)
 {
     bool okay = false;
     ConfigHandler config;
@@ -248,16 +289,10 @@ bool saveToFilesystemGUI(const QPixmap& capture)
         return okay;
     }
 
-    QFile file{ savePath };
+    QSaveFile file{ savePath };
     file.open(QIODevice::WriteOnly);
 
-    QString saveExtension;
-    saveExtension = QFileInfo(savePath).suffix().toLower();
-    if (saveExtension == "jpg" || saveExtension == "jpeg") {
-        okay = capture.save(&file, nullptr, ConfigHandler().jpegQuality());
-    } else {
-        okay = capture.save(&file);
-    }
+    okay = writeCapture(file, capture);
 
     if (okay) {
         QString pathNoFile =
@@ -3,14 +3,16 @@
 
 #pragma once
 
+#include "src/utils/encodedcapture.h"
 #include <QString>
 
-class QPixmap;
-
-bool saveToFilesystem(const QPixmap& capture,
+void saveToFilesystem(const EncodedCapture& capture,
                       const QString& path,
                       const QString& messagePrefix = "");
 QString ShowSaveFileDialog(const QString& title, const QString& directory);
-void saveToClipboardMime(const QPixmap& capture, const QString& imageType);
-void saveToClipboard(const QPixmap& capture);
-bool saveToFilesystemGUI(const QPixmap& capture);
+void saveToClipboardMime(const EncodedCapture& capture,
+                         const QString& imageType);
+void saveToClipboard(const EncodedCapture& capture);
+bool saveToFilesystemGUI(const EncodedCapture& capture);
+QString saveFormat(const QString& path);
+QString clipboardFormat();
@@ -0,0 +1,136 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "sharedimage.h"
+
+#if defined(Q_OS_LINUX)
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const int requiredSeals = F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE;
+
+struct Mapping
+{
+    void* data;
+    size_t size;
+};
+
+void unmap(void* info)
+{
+    auto* mapping = static_cast<Mapping*>(info);
+    munmap(mapping->data, mapping->size);
+    delete mapping;
+}
+
+} // namespace
+#endif
+
+/**
+ * @brief Write the pixels of `image` as ARGB32 into a new sealed memfd.
+ * @param stride Set to the number of bytes per line of the written pixels
+ * @return An invalid descriptor if the memfd could not be created
+ */
+QDBusUnixFileDescriptor SharedImage::write(const QImage& image, int& stride)
+{
+#if defined(Q_OS_LINUX)
+    QImage pixels = image;
+    // RGB32 is ARGB32 with an opaque alpha channel, no need to convert it
+    if (pixels.format() != QImage::Format_ARGB32 &&
+        pixels.format() != QImage::Format_RGB32) {
+        pixels = pixels.convertToFormat(QImage::Format_ARGB32);
+    }
+    if (pixels.isNull()) {
+        return {};
+    }
+
+    int fd = memfd_create("flameshot-capture", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0) {
+        return {};
+    }
+    size_t size = static_cast<size_t>(pixels.bytesPerLine()) * pixels.height();
+    bool ok = ftruncate(fd, static_cast<off_t>(size)) == 0;
+    if (ok) {
+        void* data =
+          mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ok = data != MAP_FAILED;
+        if (ok) {
+            memcpy(data, pixels.constBits(), size);
+            munmap(data, size);
+        }
+    }
+    // Sealing for writes requires that no writable mapping is left
+    ok = ok && fcntl(fd, F_ADD_SEALS, requiredSeals | F_SEAL_SEAL) == 0;
+
+    QDBusUnixFileDescriptor res;
+    if (ok) {
+        stride = pixels.bytesPerLine();
+        res.giveFileDescriptor(fd);
+    } else {
+        close(fd);
+    }
+    return res;
+#else
+    Q_UNUSED(image)
+    Q_UNUSED(stride)
+    return {};
+#endif
+}
+
+/**
+ * @brief Map an image written by `write` without copying it.
+ * @return A null image if the descriptor is not a sealed memfd large enough
+ * for the given dimensions
+ */
+QImage SharedImage::read(const QDBusUnixFileDescriptor& fd,
+                         int width,
+                         int height,
+                         int stride)
+{
+#if defined(Q_OS_LINUX)
+    if (!fd.isValid() || width <= 0 || height <= 0 || stride < width * 4) {
+        return {};
+    }
+    // Without the seals the sender could truncate the file while it is
+    // mapped, which would crash the daemon with SIGBUS
+    int seals = fcntl(fd.fileDescriptor(), F_GET_SEALS);
+    if (seals < 0 || (seals & requiredSeals) != requiredSeals) {
+        return {};
+    }
+    struct stat info;
+    size_t size = static_cast<size_t>(stride) * height;
+    if (fstat(fd.fileDescriptor(), &info) != 0 ||
+        static_cast<size_t>(info.st_size) < size) {
+        return {};
+    }
+
+    // Writable but private, pages are only copied if written to. Qt 5 copies
+    // read-only images to set their device pixel ratio.
+    void* data = mmap(nullptr,
+                      size,
+                      PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE,
+                      fd.fileDescriptor(),
+                      0);
+    if (data == MAP_FAILED) {
+        return {};
+    }
+    return QImage(static_cast<uchar*>(data),
+                  width,
+                  height,
+                  stride,
+                  QImage::Format_ARGB32,
+                  unmap,
+                  new Mapping{ data, size });
+#else
+    Q_UNUSED(fd)
+    Q_UNUSED(width)
+    Q_UNUSED(height)
+    Q_UNUSED(stride)
+    return {};
+#endif
+}
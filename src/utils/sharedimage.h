@@ -0,0 +1,28 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include <QDBusUnixFileDescriptor>
+#include <QImage>
+
+/**
+ * @brief Pass raw image pixels to another process through a sealed memfd.
+ *
+ * The pixels are written once into an anonymous file which is sent over
+ * D-Bus as a file descriptor, so the image is neither encoded nor copied
+ * through the bus. The receiver maps the file straight into a `QImage`.
+ * The file is sealed so that the sender can not modify or shrink it while it
+ * is mapped by the receiver.
+ *
+ * @note Only available on Linux, an invalid descriptor is returned elsewhere.
+ */
+class SharedImage
+{
+public:
+    static QDBusUnixFileDescriptor write(const QImage& image, int& stride);
+    static QImage read(const QDBusUnixFileDescriptor& fd,
+                       int width,
+                       int height,
+                       int stride);
+};
@@ -66,39 +66,51 @@ std::vector<char> match_specifiers(std::string const& specifier,
 
 std::string format_time_string(std::string const& specifier)
 {
+    return format_time_string(compile_time_pattern(specifier),
+                              std::time(nullptr));
+}
 
+time_pattern compile_time_pattern(std::string const& specifier)
+{
+    time_pattern pattern;
+    pattern.specifier = specifier;
     if (specifier.empty()) {
-        return "";
+        return pattern;
     }
 
-    std::time_t t = std::time(nullptr);
-    char buff[100];
+    static auto const allowed_specifier = create_specifier_list();
 
-    auto allowed_specifier = create_specifier_list();
-
-    auto overlap = match_specifiers(specifier, allowed_specifier);
+    pattern.overlap = match_specifiers(specifier, allowed_specifier);
 
     // Create "Safe" string for strftime which is the specfiers delimited by *
-    std::string lookup_string;
-    for (auto const& e : overlap) {
-        lookup_string.push_back('%');
-        lookup_string.push_back(e);
-        lookup_string.push_back('*');
+    for (auto const& e : pattern.overlap) {
+        pattern.lookup_string.push_back('%');
+        pattern.lookup_string.push_back(e);
+        pattern.lookup_string.push_back('*');
     }
+    return pattern;
+}
 
+std::string format_time_string(time_pattern const& pattern, std::time_t t)
+{
+    if (pattern.overlap.empty()) {
+        return pattern.specifier;
+    }
+
+    char buff[100];
     std::strftime(
-      buff, sizeof(buff), lookup_string.c_str(), std::localtime(&t));
+      buff, sizeof(buff), pattern.lookup_string.c_str(), std::localtime(&t));
 
     std::map<char, std::string> lookup_table;
     auto result = split(buff, '*');
 
     for (size_t i = 0; i < result.size(); i++) {
-        lookup_table.emplace(std::make_pair(overlap[i], result[i]));
+        lookup_table.emplace(std::make_pair(pattern.overlap[i], result[i]));
     }
 
     // Sub into original string
     std::string delim = "%";
-    auto output_string = specifier;
+    auto output_string = pattern.specifier;
     for (auto const& row : lookup_table) {
         auto to_find = delim + row.first;
         output_string = replace_all(output_string, to_find, row.second);
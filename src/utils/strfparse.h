@@ -5,6 +5,7 @@
 #include <ctime>
 #include <map>
 #include <sstream>
+#include <string>
 #include <vector>
 
 namespace strfparse {
@@ -20,4 +21,16 @@ std::vector<char> match_specifiers(std::string const& specifier,
                                    std::vector<char> allowed_specifier);
 
 std::string format_time_string(std::string const& specifier);
+
+// A pattern whose specifiers have been extracted once, for repeated use
+struct time_pattern
+{
+    std::string specifier;
+    std::vector<char> overlap;
+    std::string lookup_string;
+};
+
+time_pattern compile_time_pattern(std::string const& specifier);
+
+std::string format_time_string(time_pattern const& pattern, std::time_t t);
 }
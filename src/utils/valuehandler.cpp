@@ -7,6 +7,7 @@
 #include <QFileInfo>
 #include <QImageWriter>
 #include <QKeySequence>
+#include <QSize>
 #include <QStandardPaths>
 #include <QVariant>
 
@@ -508,6 +509,68 @@ QString SaveFileExtension::expected()
     return QStringLiteral("supported image extension");
 }
 
+// PNG FILTER
+
+bool PngFilter::check(const QVariant& val)
+{
+    QString str = val.toString();
+    return str == "adaptive" || str == "fast";
+}
+
+QVariant PngFilter::fallback()
+{
+    return QStringLiteral("adaptive");
+}
+
+QString PngFilter::expected()
+{
+    return QStringLiteral("adaptive or fast");
+}
+
+// MAX SIZE
+
+bool MaxSize::check(const QVariant& val)
+{
+    // Empty for no limit
+    return val.toString().isEmpty() || process(val).toSize().isValid();
+}
+
+QVariant MaxSize::process(const QVariant& val)
+{
+    if (val.type() == QVariant::Size) {
+        return val;
+    }
+
+    QRegExp regex("(\\d+)x(\\d+)");
+    if (!regex.exactMatch(val.toString())) {
+        return QSize();
+    }
+    int w = regex.cap(1).toInt(), h = regex.cap(2).toInt();
+    if (w <= 0 || h <= 0) {
+        return QSize();
+    }
+    return QSize(w, h);
+}
+
+QVariant MaxSize::fallback()
+{
+    return QSize();
+}
+
+QVariant MaxSize::representation(const QVariant& val)
+{
+    QSize size = val.toSize();
+    if (!size.isValid()) {
+        return QString();
+    }
+    return QStringLiteral("%1x%2").arg(size.width()).arg(size.height());
+}
+
+QString MaxSize::expected()
+{
+    return QStringLiteral("WxH, e.g. 1920x1080, or empty for no limit");
+}
+
 // REGION
 
 bool Region::check(const QVariant& val)
@@ -208,8 +208,30 @@ private:
 
 class SaveFileExtension : public ValueHandler
 {
+public:
+    bool check(const QVariant& val) override;
+
+private:
+    QVariant process(const QVariant& val) override;
+    QString expected() override;
+};
+
+class PngFilter : public ValueHandler
+{
+    bool check(const QVariant& val) override;
+    QVariant fallback() override;
+    QString expected() override;
+};
+
+class MaxSize : public ValueHandler
+{
+public:
     bool check(const QVariant& val) override;
+    QVariant representation(const QVariant& val) override;
+
+private:
     QVariant process(const QVariant& val) override;
+    QVariant fallback() override;
     QString expected() override;
 };
 
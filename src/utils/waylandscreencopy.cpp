@@ -0,0 +1,631 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "waylandscreencopy.h"
+#include "abstractlogger.h"
+#include "desktopstitcher.h"
+#include "wlr-screencopy-unstable-v1-client-protocol.h"
+#include "xdg-output-unstable-v1-client-protocol.h"
+#include <QTransform>
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <wayland-client.h>
+
+namespace {
+
+/**
+ * @brief State of a single screencopy frame while the compositor fills it.
+ */
+struct Frame
+{
+    enum State
+    {
+        Pending,
+        Ready,
+        Failed
+    };
+
+    zwlr_screencopy_frame_v1* handle = nullptr;
+    wl_shm* shm = nullptr;
+    uint32_t format = 0;
+    int width = 0;
+    int height = 0;
+    int stride = 0;
+    bool hasShmBuffer = false;
+    bool yInvert = false;
+    wl_buffer* buffer = nullptr;
+    void* data = nullptr;
+    size_t size = 0;
+    State state = Pending;
+};
+
+struct Mapping
+{
+    void* data;
+    size_t size;
+};
+
+QImage::Format imageFormat(uint32_t shmFormat)
+{
+    switch (shmFormat) {
+        case WL_SHM_FORMAT_ARGB8888:
+            return QImage::Format_ARGB32_Premultiplied;
+        case WL_SHM_FORMAT_XRGB8888:
+            return QImage::Format_RGB32;
+        case WL_SHM_FORMAT_ABGR8888:
+            return QImage::Format_RGBA8888_Premultiplied;
+        case WL_SHM_FORMAT_XBGR8888:
+            return QImage::Format_RGBX8888;
+        case WL_SHM_FORMAT_XRGB2101010:
+            return QImage::Format_RGB30;
+        case WL_SHM_FORMAT_XBGR2101010:
+            return QImage::Format_BGR30;
+        default:
+            return QImage::Format_Invalid;
+    }
+}
+
+void unmapBuffer(void* info)
+{
+    auto* mapping = static_cast<Mapping*>(info);
+    munmap(mapping->data, mapping->size);
+    delete mapping;
+}
+
+/**
+ * @brief Allocate a wl_shm buffer matching the frame and ask the compositor to
+ * copy the output into it.
+ */
+void copyFrame(Frame* frame, zwlr_screencopy_frame_v1* handle)
+{
+    frame->size = static_cast<size_t>(frame->stride) * frame->height;
+    int fd = memfd_create("flameshot-screencopy", MFD_CLOEXEC);
+    if (fd == -1) {
+        frame->state = Frame::Failed;
+        return;
+    }
+    if (ftruncate(fd, static_cast<off_t>(frame->size)) == -1) {
+        close(fd);
+        frame->state = Frame::Failed;
+        return;
+    }
+    frame->data =
+      mmap(nullptr, frame->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (frame->data == MAP_FAILED) {
+        frame->data = nullptr;
+        close(fd);
+        frame->state = Frame::Failed;
+        return;
+    }
+
+    wl_shm_pool* pool =
+      wl_shm_create_pool(frame->shm, fd, static_cast<int32_t>(frame->size));
+    frame->buffer = wl_shm_pool_create_buffer(
+      pool, 0, frame->width, frame->height, frame->stride, frame->format);
+    wl_shm_pool_destroy(pool);
+    close(fd);
+
+    zwlr_screencopy_frame_v1_copy(handle, frame->buffer);
+}
+
+// FRAME EVENTS
+
+void frameBuffer(void* data,
+                 zwlr_screencopy_frame_v1* handle,
+                 uint32_t format,
+                 uint32_t width,
+                 uint32_t height,
+                 uint32_t stride)
+{
+    auto* frame = static_cast<Frame*>(data);
+    if (frame->hasShmBuffer || imageFormat(format) == QImage::Format_Invalid) {
+        return;
+    }
+    frame->hasShmBuffer = true;
+    frame->format = format;
+    frame->width = static_cast<int>(width);
+    frame->height = static_cast<int>(height);
+    frame->stride = static_cast<int>(stride);
+
+    // Before version 3 the buffer event is the only one announcing a buffer
+    // type, so the copy can be requested right away
+    if (zwlr_screencopy_frame_v1_get_version(handle) < 3) {
+        copyFrame(frame, handle);
+    }
+}
+
+void frameFlags(void* data, zwlr_screencopy_frame_v1*, uint32_t flags)
+{
+    auto* frame = static_cast<Frame*>(data);
+    frame->yInvert = flags & ZWLR_SCREENCOPY_FRAME_V1_FLAGS_Y_INVERT;
+}
+
+void frameReady(void* data,
+                zwlr_screencopy_frame_v1*,
+                uint32_t,
+                uint32_t,
+                uint32_t)
+{
+    static_cast<Frame*>(data)->state = Frame::Ready;
+}
+
+void frameFailed(void* data, zwlr_screencopy_frame_v1*)
+{
+    static_cast<Frame*>(data)->state = Frame::Failed;
+}
+
+void frameDamage(void*,
+                 zwlr_screencopy_frame_v1*,
+                 uint32_t,
+                 uint32_t,
+                 uint32_t,
+                 uint32_t)
+{}
+
+void frameLinuxDmabuf(void*,
+                      zwlr_screencopy_frame_v1*,
+                      uint32_t,
+                      uint32_t,
+                      uint32_t)
+{}
+
+void frameBufferDone(void* data, zwlr_screencopy_frame_v1* handle)
+{
+    auto* frame = static_cast<Frame*>(data);
+    if (!frame->hasShmBuffer) {
+        frame->state = Frame::Failed;
+        return;
+    }
+    copyFrame(frame, handle);
+}
+
+const zwlr_screencopy_frame_v1_listener frameListener = {
+    frameBuffer, frameFlags,       frameReady,      frameFailed,
+    frameDamage, frameLinuxDmabuf, frameBufferDone,
+};
+
+// OUTPUT EVENTS
+
+void outputGeometry(void* data,
+                    wl_output*,
+                    int32_t x,
+                    int32_t y,
+                    int32_t,
+                    int32_t,
+                    int32_t,
+                    const char*,
+                    const char*,
+                    int32_t transform)
+{
+    auto* output = static_cast<WaylandScreencopy::Output*>(data);
+    if (output->xdgOutput == nullptr) {
+        output->logicalGeometry.moveTo(x, y);
+    }
+    output->transform = transform;
+}
+
+void outputMode(void* data,
+                wl_output*,
+                uint32_t flags,
+                int32_t width,
+                int32_t height,
+                int32_t)
+{
+    auto* output = static_cast<WaylandScreencopy::Output*>(data);
+    if (flags & WL_OUTPUT_MODE_CURRENT) {
+        output->modeSize = QSize(width, height);
+    }
+}
+
+void outputDone(void*, wl_output*) {}
+
+void outputScale(void* data, wl_output*, int32_t factor)
+{
+    static_cast<WaylandScreencopy::Output*>(data)->scale = factor;
+}
+
+const wl_output_listener outputListener = {
+    outputGeometry,
+    outputMode,
+    outputDone,
+    outputScale,
+};
+
+// XDG OUTPUT EVENTS
+
+void xdgOutputLogicalPosition(void* data,
+                              zxdg_output_v1*,
+                              int32_t x,
+                              int32_t y)
+{
+    static_cast<WaylandScreencopy::Output*>(data)->logicalGeometry.moveTo(x,
+                                                                          y);
+}
+
+void xdgOutputLogicalSize(void* data,
+                          zxdg_output_v1*,
+                          int32_t width,
+                          int32_t height)
+{
+    static_cast<WaylandScreencopy::Output*>(data)->logicalGeometry.setSize(
+      QSize(width, height));
+}
+
+void xdgOutputDone(void*, zxdg_output_v1*) {}
+
+void xdgOutputName(void* data, zxdg_output_v1*, const char* name)
+{
+    static_cast<WaylandScreencopy::Output*>(data)->name =
+      QString::fromUtf8(name);
+}
+
+void xdgOutputDescription(void*, zxdg_output_v1*, const char*) {}
+
+const zxdg_output_v1_listener xdgOutputListener = {
+    xdgOutputLogicalPosition, xdgOutputLogicalSize, xdgOutputDone,
+    xdgOutputName,            xdgOutputDescription,
+};
+
+void addXdgOutput(zxdg_output_manager_v1* manager,
+                  WaylandScreencopy::Output* output)
+{
+    output->xdgOutput =
+      zxdg_output_manager_v1_get_xdg_output(manager, output->output);
+    zxdg_output_v1_add_listener(
+      output->xdgOutput, &xdgOutputListener, output);
+}
+
+/**
+ * @brief Ask the compositor for a frame of `output`, or of the `region` of it
+ * if it is not null. The frame is filled asynchronously.
+ */
+Frame* requestFrame(zwlr_screencopy_manager_v1* manager,
+                    wl_shm* shm,
+                    const WaylandScreencopy::Output* output,
+                    const QRect& region)
+{
+    auto* frame = new Frame();
+    frame->shm = shm;
+    if (region.isNull()) {
+        frame->handle =
+          zwlr_screencopy_manager_v1_capture_output(manager, 0, output->output);
+    } else {
+        frame->handle =
+          zwlr_screencopy_manager_v1_capture_output_region(manager,
+                                                           0,
+                                                           output->output,
+                                                           region.x(),
+                                                           region.y(),
+                                                           region.width(),
+                                                           region.height());
+    }
+    zwlr_screencopy_frame_v1_add_listener(frame->handle, &frameListener, frame);
+    return frame;
+}
+
+/**
+ * @brief Dispatch events until none of the frames is pending anymore.
+ */
+void waitForFrames(wl_display* display, const QList<Frame*>& frames)
+{
+    auto pending = [&frames]() {
+        for (const Frame* frame : frames) {
+            if (frame->state == Frame::Pending) {
+                return true;
+            }
+        }
+        return false;
+    };
+    while (pending()) {
+        if (wl_display_dispatch(display) == -1) {
+            for (Frame* frame : frames) {
+                if (frame->state == Frame::Pending) {
+                    frame->state = Frame::Failed;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Release the protocol objects of a finished frame and wrap its
+ * pixels in an image in the logical orientation of the output.
+ */
+QImage takeFrameImage(Frame* frame, const WaylandScreencopy::Output* output)
+{
+    zwlr_screencopy_frame_v1_destroy(frame->handle);
+    if (frame->buffer != nullptr) {
+        wl_buffer_destroy(frame->buffer);
+    }
+
+    if (frame->state == Frame::Failed) {
+        if (frame->data != nullptr) {
+            munmap(frame->data, frame->size);
+        }
+        delete frame;
+        AbstractLogger::error()
+          << QObject::tr("Unable to capture output %1 via screencopy")
+               .arg(output->name);
+        return {};
+    }
+
+    // The image takes ownership of the mapping, so no pixel is copied here
+    QImage image(static_cast<uchar*>(frame->data),
+                 frame->width,
+                 frame->height,
+                 frame->stride,
+                 imageFormat(frame->format),
+                 unmapBuffer,
+                 new Mapping{ frame->data, frame->size });
+    bool yInvert = frame->yInvert;
+    delete frame;
+
+    if (yInvert) {
+        image = image.mirrored(false, true);
+    }
+    if (output->transform != WL_OUTPUT_TRANSFORM_NORMAL) {
+        // Undo the transform the compositor applied for the output
+        QTransform rotation;
+        rotation.rotate(90 * (output->transform & 3));
+        image = image.transformed(rotation);
+        if (output->transform & WL_OUTPUT_TRANSFORM_FLIPPED) {
+            image = image.mirrored(true, false);
+        }
+    }
+    return image;
+}
+
+} // namespace
+
+// REGISTRY EVENTS
+
+struct WaylandScreencopyListeners
+{
+    static void global(void* data,
+                       wl_registry*,
+                       uint32_t name,
+                       const char* interface,
+                       uint32_t version)
+    {
+        static_cast<WaylandScreencopy*>(data)->addGlobal(
+          name, interface, version);
+    }
+
+    static void globalRemove(void* data, wl_registry*, uint32_t name)
+    {
+        static_cast<WaylandScreencopy*>(data)->removeGlobal(name);
+    }
+};
+
+static const wl_registry_listener registryListener = {
+    WaylandScreencopyListeners::global,
+    WaylandScreencopyListeners::globalRemove,
+};
+
+// CLASS WAYLANDSCREENCOPY
+
+WaylandScreencopy::WaylandScreencopy()
+  : m_display(nullptr)
+  , m_registry(nullptr)
+  , m_shm(nullptr)
+  , m_xdgOutputManager(nullptr)
+  , m_screencopyManager(nullptr)
+{
+    m_display = wl_display_connect(nullptr);
+    if (m_display == nullptr) {
+        return;
+    }
+    m_registry = wl_display_get_registry(m_display);
+    wl_registry_add_listener(m_registry, &registryListener, this);
+    wl_display_roundtrip(m_display);
+
+    // The xdg output manager may be announced after some of the outputs
+    if (m_xdgOutputManager != nullptr) {
+        for (Output* output : m_outputs) {
+            if (output->xdgOutput == nullptr) {
+                addXdgOutput(m_xdgOutputManager, output);
+            }
+        }
+    }
+    // Receive the geometry of every output
+    wl_display_roundtrip(m_display);
+
+    for (Output* output : m_outputs) {
+        if (output->xdgOutput != nullptr) {
+            continue;
+        }
+        // Without xdg-output the logical size has to be derived from the mode
+        QSize size = output->modeSize / qMax(1, output->scale);
+        if (output->transform & WL_OUTPUT_TRANSFORM_90) {
+            size.transpose();
+        }
+        output->logicalGeometry.setSize(size);
+    }
+}
+
+WaylandScreencopy::~WaylandScreencopy()
+{
+    for (Output* output : m_outputs) {
+        if (output->xdgOutput != nullptr) {
+            zxdg_output_v1_destroy(output->xdgOutput);
+        }
+        wl_output_destroy(output->output);
+        delete output;
+    }
+    if (m_screencopyManager != nullptr) {
+        zwlr_screencopy_manager_v1_destroy(m_screencopyManager);
+    }
+    if (m_xdgOutputManager != nullptr) {
+        zxdg_output_manager_v1_destroy(m_xdgOutputManager);
+    }
+    if (m_shm != nullptr) {
+        wl_shm_destroy(m_shm);
+    }
+    if (m_registry != nullptr) {
+        wl_registry_destroy(m_registry);
+    }
+    if (m_display != nullptr) {
+        wl_display_disconnect(m_display);
+    }
+}
+
+/**
+ * @brief Whether the compositor supports wlroots screencopy.
+ */
+bool WaylandScreencopy::isAvailable() const
+{
+    return m_screencopyManager != nullptr && m_shm != nullptr &&
+           !m_outputs.isEmpty();
+}
+
+const QList<WaylandScreencopy::Output*>& WaylandScreencopy::outputs() const
+{
+    return m_outputs;
+}
+
+/**
+ * @brief Capture a single output, or the `region` of it (in logical
+ * coordinates local to the output) if it is not null.
+ *
+ * The returned image is in the logical orientation of the output and has the
+ * physical resolution of the output. A null image is returned on failure.
+ */
+QImage WaylandScreencopy::grabOutput(const Output* output, const QRect& region)
+{
+    Frame* frame = requestFrame(m_screencopyManager, m_shm, output, region);
+    waitForFrames(m_display, { frame });
+    return takeFrameImage(frame, output);
+}
+
+/**
+ * @brief Capture the `region` of the desktop (in logical compositor
+ * coordinates).
+ *
+ * Only the parts of the outputs that intersect the region are transferred by
+ * the compositor. The frames of all outputs are requested at once, so the
+ * compositor copies them concurrently, and each one is stitched into the
+ * preallocated result as soon as it is available. Like grim, the result is
+ * rendered at the highest scale of the captured outputs.
+ */
+QImage WaylandScreencopy::grabRegion(const QRect& region)
+{
+    QList<const Output*> outputs;
+    QList<QRect> parts;
+    QList<Frame*> frames;
+    for (const Output* output : m_outputs) {
+        QRect part = output->logicalGeometry.intersected(region);
+        if (part.isEmpty()) {
+            continue;
+        }
+        QRect local;
+        if (part != output->logicalGeometry) {
+            local = part.translated(-output->logicalGeometry.topLeft());
+        }
+        outputs.append(output);
+        parts.append(part);
+        frames.append(
+          requestFrame(m_screencopyManager, m_shm, output, local));
+    }
+    if (frames.isEmpty()) {
+        return {};
+    }
+
+    waitForFrames(m_display, frames);
+
+    QList<QImage> images;
+    qreal scale = 1;
+    bool ok = true;
+    for (int i = 0; i < frames.size(); ++i) {
+        QImage image = takeFrameImage(frames[i], outputs[i]);
+        ok = ok && !image.isNull();
+        if (ok) {
+            scale = qMax(scale,
+                         static_cast<qreal>(image.width()) / parts[i].width());
+        }
+        images.append(image);
+    }
+    if (!ok) {
+        return {};
+    }
+    if (images.size() == 1 && parts.constFirst() == region) {
+        return images.constFirst();
+    }
+
+    DesktopStitcher stitcher(region.size() * scale);
+    for (int i = 0; i < images.size(); ++i) {
+        QRect part = parts[i].translated(-region.topLeft());
+        stitcher.add(images[i], DesktopStitcher::scaledRect(part, scale));
+    }
+    return stitcher.result();
+}
+
+/**
+ * @brief Capture all outputs and compose them into a single image.
+ */
+QImage WaylandScreencopy::grabDesktop()
+{
+    return grabRegion(desktopGeometry());
+}
+
+void WaylandScreencopy::addGlobal(uint32_t name,
+                                  const char* interface,
+                                  uint32_t version)
+{
+    if (strcmp(interface, wl_shm_interface.name) == 0) {
+        m_shm = static_cast<wl_shm*>(
+          wl_registry_bind(m_registry, name, &wl_shm_interface, 1));
+    } else if (strcmp(interface, wl_output_interface.name) == 0) {
+        auto* output = new Output();
+        output->globalName = name;
+        output->output = static_cast<wl_output*>(wl_registry_bind(
+          m_registry, name, &wl_output_interface, qMin(version, 2u)));
+        wl_output_add_listener(output->output, &outputListener, output);
+        if (m_xdgOutputManager != nullptr) {
+            addXdgOutput(m_xdgOutputManager, output);
+        }
+        m_outputs.append(output);
+    } else if (strcmp(interface, zxdg_output_manager_v1_interface.name) == 0) {
+        m_xdgOutputManager =
+          static_cast<zxdg_output_manager_v1*>(wl_registry_bind(
+            m_registry,
+            name,
+            &zxdg_output_manager_v1_interface,
+            qMin(version, 3u)));
+    } else if (strcmp(interface, zwlr_screencopy_manager_v1_interface.name) ==
+               0) {
+        m_screencopyManager =
+          static_cast<zwlr_screencopy_manager_v1*>(wl_registry_bind(
+            m_registry,
+            name,
+            &zwlr_screencopy_manager_v1_interface,
+            qMin(version, 3u)));
+    }
+}
+
+void WaylandScreencopy::removeGlobal(uint32_t name)
+{
+    for (int i = 0; i < m_outputs.size(); ++i) {
+        Output* output = m_outputs[i];
+        if (output->globalName == name) {
+            if (output->xdgOutput != nullptr) {
+                zxdg_output_v1_destroy(output->xdgOutput);
+            }
+            wl_output_destroy(output->output);
+            delete output;
+            m_outputs.removeAt(i);
+            return;
+        }
+    }
+}
+
+QRect WaylandScreencopy::desktopGeometry() const
+{
+    QRect geometry;
+    for (const Output* output : m_outputs) {
+        geometry = geometry.united(output->logicalGeometry);
+    }
+    return geometry;
+}
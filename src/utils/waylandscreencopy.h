@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include <QImage>
+#include <QList>
+#include <QRect>
+#include <QString>
+
+struct wl_display;
+struct wl_registry;
+struct wl_output;
+struct wl_shm;
+struct zxdg_output_manager_v1;
+struct zxdg_output_v1;
+struct zwlr_screencopy_manager_v1;
+
+/**
+ * @brief In-process screen capture through the wlroots screencopy protocol.
+ *
+ * The compositor copies each output straight into a wl_shm buffer which is
+ * then mapped into a `QImage` without any copy, subprocess or image encoding.
+ * This is used on wlroots based compositors (sway, Hyprland, river, ...) in
+ * place of running `grim`, which stays as a fallback.
+ *
+ * A separate Wayland connection is opened so that the protocol objects do not
+ * interfere with the one owned by the Qt platform plugin.
+ */
+class WaylandScreencopy
+{
+public:
+    struct Output
+    {
+        wl_output* output = nullptr;
+        zxdg_output_v1* xdgOutput = nullptr;
+        uint32_t globalName = 0;
+        QString name;
+        QRect logicalGeometry;
+        QSize modeSize;
+        int32_t transform = 0;
+        int32_t scale = 1;
+    };
+
+    WaylandScreencopy();
+    ~WaylandScreencopy();
+
+    bool isAvailable() const;
+    const QList<Output*>& outputs() const;
+
+    QImage grabOutput(const Output* output, const QRect& region = QRect());
+    QImage grabRegion(const QRect& region);
+    QImage grabDesktop();
+
+private:
+    void addGlobal(uint32_t name, const char* interface, uint32_t version);
+    void removeGlobal(uint32_t name);
+    QRect desktopGeometry() const;
+
+    wl_display* m_display;
+    wl_registry* m_registry;
+    wl_shm* m_shm;
+    zxdg_output_manager_v1* m_xdgOutputManager;
+    zwlr_screencopy_manager_v1* m_screencopyManager;
+    QList<Output*> m_outputs;
+
+    friend struct WaylandScreencopyListeners;
+};
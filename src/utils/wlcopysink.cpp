@@ -0,0 +1,361 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "wlcopysink.h"
+#include "abstractlogger.h"
+#include <QCoreApplication>
+#include <QLoggingCategory>
+#include <QProcess>
+#include <QSocketNotifier>
+#include <QTimer>
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+Q_LOGGING_CATEGORY(lcWlCopy, "flameshot.wlcopy", QtInfoMsg)
+
+namespace {
+
+// Large enough to fill the pipe buffer in a single call
+const int chunkSize = 64 * 1024;
+// Used to reap the child when pidfds are not supported
+const int exitPollInterval = 50;
+
+void logErr(const QString& name)
+{
+    AbstractLogger::error()
+      << "wl_copy: " + name + ": " + QString::fromLocal8Bit(strerror(errno));
+}
+
+int openPidfd(pid_t pid)
+{
+#ifdef SYS_pidfd_open
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+    Q_UNUSED(pid)
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+} // namespace
+
+/**
+ * @brief Start `wl-copy` offering `mimeType`.
+ * @return nullptr if the process could not be started
+ */
+WlCopySink* WlCopySink::start(const QString& mimeType)
+{
+    // Writing to the pipe after wl-copy died must fail with EPIPE instead of
+    // killing flameshot
+    signal(SIGPIPE, SIG_IGN);
+
+    int pipefds[2];
+    if (pipe2(pipefds, O_CLOEXEC) == -1) {
+        logErr("pipe2");
+        return nullptr;
+    }
+    // Prepared before forking, only async-signal-safe calls are allowed in
+    // the child
+    QByteArray type = mimeType.toUtf8();
+
+    pid_t pid = fork();
+    if (pid == -1) {
+        logErr("fork");
+        ::close(pipefds[0]);
+        ::close(pipefds[1]);
+        return nullptr;
+    }
+    if (pid == 0) {
+        if (dup2(pipefds[0], STDIN_FILENO) == -1) {
+            _exit(127);
+        }
+        execlp("wl-copy", "wl-copy", "-t", type.constData(), nullptr);
+        _exit(127);
+    }
+
+    ::close(pipefds[0]);
+    fcntl(pipefds[1], F_SETFL, fcntl(pipefds[1], F_GETFL) | O_NONBLOCK);
+    return new WlCopySink(pid, pipefds[1]);
+}
+
+WlCopySink::WlCopySink(pid_t pid, int pipe)
+  : QObject(qApp)
+  , m_pid(pid)
+  , m_pipe(pipe)
+  , m_pidfd(-1)
+  , m_offset(0)
+  , m_closed(false)
+  , m_failed(false)
+  , m_reaped(false)
+  , m_writeNotifier(new QSocketNotifier(pipe, QSocketNotifier::Write, this))
+  , m_exitNotifier(nullptr)
+  , m_exitTimer(nullptr)
+{
+    m_writeNotifier->setEnabled(false);
+    connect(m_writeNotifier,
+            &QSocketNotifier::activated,
+            this,
+            &WlCopySink::writePending);
+    // Don't leave a truncated image behind if flameshot quits meanwhile
+    connect(qApp, &QCoreApplication::aboutToQuit, this, &WlCopySink::flush);
+}
+
+WlCopySink::~WlCopySink()
+{
+    if (m_pipe != -1) {
+        ::close(m_pipe);
+    }
+    if (m_pidfd != -1) {
+        ::close(m_pidfd);
+    }
+}
+
+/**
+ * @brief Queue `data`, which is written as soon as the pipe accepts it.
+ */
+void WlCopySink::write(const QByteArray& data)
+{
+    if (m_closed || m_failed || data.isEmpty()) {
+        return;
+    }
+    m_pending.append(data);
+    writePending();
+}
+
+/**
+ * @brief Signal that all the data has been written.
+ */
+void WlCopySink::close()
+{
+    m_closed = true;
+    if (m_pending.isEmpty()) {
+        closePipe();
+    }
+}
+
+/**
+ * @brief Drop the data that is left and stop `wl-copy`, so that it doesn't
+ * offer an incomplete image.
+ */
+void WlCopySink::abort()
+{
+    m_failed = true;
+    m_pending.clear();
+    kill(m_pid, SIGTERM);
+    closePipe();
+}
+
+void WlCopySink::writePending()
+{
+    while (!m_pending.isEmpty()) {
+        const QByteArray& chunk = m_pending.constFirst();
+        size_t size = qMin(chunk.size() - m_offset, chunkSize);
+        ssize_t written = ::write(m_pipe, chunk.constData() + m_offset, size);
+        if (written == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                m_writeNotifier->setEnabled(true);
+                return;
+            }
+            logErr("write");
+            m_failed = true;
+            m_pending.clear();
+            break;
+        }
+        m_offset += static_cast<int>(written);
+        if (m_offset == chunk.size()) {
+            m_pending.removeFirst();
+            m_offset = 0;
+        }
+    }
+    m_writeNotifier->setEnabled(false);
+    if (m_closed || m_failed) {
+        closePipe();
+    }
+}
+
+void WlCopySink::closePipe()
+{
+    if (m_pipe == -1) {
+        return;
+    }
+    m_writeNotifier->setEnabled(false);
+    ::close(m_pipe);
+    m_pipe = -1;
+    watchChild();
+}
+
+void WlCopySink::watchChild()
+{
+    m_pidfd = openPidfd(m_pid);
+    if (m_pidfd != -1) {
+        m_exitNotifier =
+          new QSocketNotifier(m_pidfd, QSocketNotifier::Read, this);
+        connect(m_exitNotifier,
+                &QSocketNotifier::activated,
+                this,
+                &WlCopySink::reap);
+    } else {
+        m_exitTimer = new QTimer(this);
+        connect(m_exitTimer, &QTimer::timeout, this, &WlCopySink::reap);
+        m_exitTimer->start(exitPollInterval);
+    }
+}
+
+void WlCopySink::reap()
+{
+    if (m_reaped) {
+        return;
+    }
+    int status = 0;
+    pid_t res = waitpid(m_pid, &status, WNOHANG);
+    if (res == 0 || (res == -1 && errno == EINTR)) {
+        return;
+    }
+    finish(res == m_pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+/**
+ * @brief Report the outcome once the child has been reaped, `exited` being
+ * whether it exited successfully.
+ */
+void WlCopySink::finish(bool exited)
+{
+    m_reaped = true;
+    if (m_exitNotifier != nullptr) {
+        m_exitNotifier->setEnabled(false);
+    }
+    if (m_exitTimer != nullptr) {
+        m_exitTimer->stop();
+    }
+
+    bool ok = !m_failed && exited;
+    if (!ok) {
+        AbstractLogger::error() << QObject::tr("wl-copy failed");
+    } else if (lcWlCopy().isDebugEnabled()) {
+        reportOfferedTypes();
+    }
+    emit finished(ok);
+    deleteLater();
+}
+
+/**
+ * @brief Write everything that is left and wait for wl-copy, blocking.
+ */
+void WlCopySink::flush()
+{
+    // The data handed over by a WlCopyDevice is queued to the application,
+    // which may not process events again
+    QCoreApplication::sendPostedEvents(qApp, QEvent::MetaCall);
+    if (m_pipe != -1) {
+        pollfd fd = { m_pipe, POLLOUT, 0 };
+        while (!m_pending.isEmpty() && !m_failed) {
+            poll(&fd, 1, -1);
+            writePending();
+        }
+        closePipe();
+    }
+    if (!m_reaped) {
+        int status = 0;
+        pid_t res;
+        do {
+            res = waitpid(m_pid, &status, 0);
+        } while (res == -1 && errno == EINTR);
+        finish(res == m_pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    }
+}
+
+/**
+ * @brief Log the MIME types the clipboard ends up offering, which costs a
+ * `wl-paste` process.
+ *
+ * wl-copy may offer aliases of the requested type as well.
+ */
+void WlCopySink::reportOfferedTypes()
+{
+    auto* process = new QProcess(qApp);
+    connect(process,
+            QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            process,
+            [process]() {
+                QStringList types =
+                  QString::fromUtf8(process->readAllStandardOutput())
+                    .trimmed()
+                    .split('\n');
+                qCDebug(lcWlCopy) << "Clipboard offers:" << types;
+                process->deleteLater();
+            });
+    connect(process, &QProcess::errorOccurred, process, &QObject::deleteLater);
+    process->start("wl-paste", { "--list-types" });
+}
+
+WlCopyDevice::WlCopyDevice(WlCopySink* sink)
+  : m_sink(sink)
+{}
+
+/**
+ * @brief Hand the data that is left to the sink, then close it if `ok`, or
+ * abort it.
+ */
+void WlCopyDevice::finish(bool ok)
+{
+    post(m_buffer);
+    m_buffer.clear();
+    QPointer<WlCopySink> sink = m_sink;
+    QMetaObject::invokeMethod(
+      qApp,
+      [sink, ok]() {
+          if (sink == nullptr) {
+              return;
+          } else if (ok) {
+              sink->close();
+          } else {
+              sink->abort();
+          }
+      },
+      Qt::QueuedConnection);
+    close();
+}
+
+qint64 WlCopyDevice::readData(char* data, qint64 maxSize)
+{
+    Q_UNUSED(data)
+    Q_UNUSED(maxSize)
+    return -1;
+}
+
+qint64 WlCopyDevice::writeData(const char* data, qint64 size)
+{
+    m_buffer.append(data, static_cast<int>(size));
+    if (m_buffer.size() >= chunkSize) {
+        post(m_buffer);
+        m_buffer.clear();
+    }
+    return size;
+}
+
+void WlCopyDevice::post(const QByteArray& data)
+{
+    if (data.isEmpty()) {
+        return;
+    }
+    // The sink lives on the GUI thread, where it may also be deleted
+    QPointer<WlCopySink> sink = m_sink;
+    QMetaObject::invokeMethod(
+      qApp,
+      [sink, data]() {
+          if (sink != nullptr) {
+              sink->write(data);
+          }
+      },
+      Qt::QueuedConnection);
+}
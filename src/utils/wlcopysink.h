@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <sys/types.h>
+
+class QSocketNotifier;
+class QTimer;
+
+/**
+ * @brief Hand data over to `wl-copy` without blocking the event loop.
+ *
+ * `wl-copy` is started with a non-blocking pipe as its standard input. Data
+ * passed to `write` is queued and written in chunks whenever the pipe is
+ * writable, so the caller can return to the event loop (and close the
+ * editor) right away and keep appending while it produces more. Once `close`
+ * has been called and the queue is drained, the pipe is closed and the child
+ * is reaped asynchronously, through a pidfd where available.
+ *
+ * The sink deletes itself when `wl-copy` has exited. The MIME types the
+ * clipboard then offers are logged to the `flameshot.wlcopy` debug category.
+ */
+class WlCopySink : public QObject
+{
+    Q_OBJECT
+public:
+    static WlCopySink* start(const QString& mimeType);
+    ~WlCopySink();
+
+    void write(const QByteArray& data);
+    void close();
+    void abort();
+
+signals:
+    void finished(bool ok);
+
+private:
+    WlCopySink(pid_t pid, int pipe);
+
+    void writePending();
+    void closePipe();
+    void watchChild();
+    void reap();
+    void finish(bool exited);
+    void flush();
+    void reportOfferedTypes();
+
+    pid_t m_pid;
+    int m_pipe;
+    int m_pidfd;
+    QList<QByteArray> m_pending;
+    int m_offset;
+    bool m_closed;
+    bool m_failed;
+    bool m_reaped;
+    QSocketNotifier* m_writeNotifier;
+    QSocketNotifier* m_exitNotifier;
+    QTimer* m_exitTimer;
+};
+
+/**
+ * @brief A device feeding a `WlCopySink` from another thread, e.g. an export
+ * job encoding the image, so that `wl-copy` receives the data while it is
+ * produced.
+ *
+ * The data is handed to the sink on the GUI thread in chunks. `finish`
+ * closes the sink, or aborts it if the data is incomplete.
+ */
+class WlCopyDevice : public QIODevice
+{
+public:
+    explicit WlCopyDevice(WlCopySink* sink);
+
+    void finish(bool ok);
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 size) override;
+
+private:
+    void post(const QByteArray& data);
+
+    QPointer<WlCopySink> m_sink;
+    QByteArray m_buffer;
+};
@@ -3,9 +3,12 @@
 
 #include "capturetoolobjects.h"
 
+#include <algorithm>
+#include <functional>
+
 #define SEARCH_RADIUS_NEAR 3
 #define SEARCH_RADIUS_FAR 5
-#define SEARCH_RADIUS_TEXT_HANDICAP 5
+#define INDEX_LEAF_SIZE 4
 
 CaptureToolObjects::CaptureToolObjects(QObject* parent)
   : QObject(parent)
@@ -15,7 +18,7 @@ void CaptureToolObjects::append(const QPointer<CaptureTool>& captureTool)
 {
     if (!captureTool.isNull()) {
         m_captureToolObjects.append(captureTool->copy(captureTool->parent()));
-        m_imageCache.clear();
+        m_indexValid = false;
     }
 }
 
@@ -26,7 +29,7 @@ void CaptureToolObjects::insert(int index,
         index <= m_captureToolObjects.size()) {
         m_captureToolObjects.insert(index,
                                     captureTool->copy(captureTool->parent()));
-        m_imageCache.clear();
+        m_indexValid = false;
     }
 }
 
@@ -38,12 +41,62 @@ QPointer<CaptureTool> CaptureToolObjects::at(int index)
     return nullptr;
 }
 
+/**
+ * @brief Replace `count` objects from `first` with `captureTools`, which are
+ * not copied.
+ */
+void CaptureToolObjects::replace(
+  int first,
+  int count,
+  const QList<QPointer<CaptureTool>>& captureTools)
+{
+    if (first < 0 || count < 0 || first + count > m_captureToolObjects.size()) {
+        return;
+    }
+    for (int i = 0; i < count; ++i) {
+        m_captureToolObjects.removeAt(first);
+    }
+    for (int i = 0; i < captureTools.size(); ++i) {
+        m_captureToolObjects.insert(first + i, captureTools[i]);
+    }
+    m_indexValid = false;
+}
+
+/**
+ * @brief Hold the same objects as `other`, without copying them. Used for
+ * the backup of the objects before a modification, with `detach` for the
+ * ones about to be changed in place.
+ */
+void CaptureToolObjects::share(const CaptureToolObjects& other)
+{
+    clear();
+    m_captureToolObjects = other.m_captureToolObjects;
+}
+
+/**
+ * @brief Replace the object at `index` with a copy, so that it keeps its
+ * current state when the shared one is changed.
+ */
+void CaptureToolObjects::detach(int index)
+{
+    if (index >= 0 && index < m_captureToolObjects.size() &&
+        !m_captureToolObjects[index].isNull()) {
+        QPointer<CaptureTool> copy = m_captureToolObjects[index]->copy(this);
+        m_captureToolObjects[index] = copy;
+        m_detached.append(copy);
+        m_indexValid = false;
+    }
+}
+
 void CaptureToolObjects::clear()
 {
     m_captureToolObjects.clear();
+    qDeleteAll(m_detached);
+    m_detached.clear();
+    m_indexValid = false;
 }
 
-QList<QPointer<CaptureTool>> CaptureToolObjects::captureToolObjects()
+QList<QPointer<CaptureTool>> CaptureToolObjects::captureToolObjects() const
 {
     return m_captureToolObjects;
 }
@@ -57,82 +110,126 @@ void CaptureToolObjects::removeAt(int index)
 {
     if (index >= 0 && index < m_captureToolObjects.size()) {
         m_captureToolObjects.removeAt(index);
-        m_imageCache.clear();
+        m_indexValid = false;
     }
 }
 
-int CaptureToolObjects::find(const QPoint& pos, QSize captureSize)
+/**
+ * @brief Index of the topmost object drawn at `pos`, or -1.
+ */
+int CaptureToolObjects::find(const QPoint& pos)
 {
     if (m_captureToolObjects.empty()) {
         return -1;
     }
-    QPixmap pixmap(captureSize);
-    pixmap.fill(Qt::transparent);
-    QPainter painter(&pixmap);
+    if (!m_indexValid) {
+        buildIndex();
+    }
     // first attempt to find at exact position
-    int radius = SEARCH_RADIUS_NEAR;
-    int index = findWithRadius(painter, pixmap, pos, radius);
+    int index = findWithRadius(pos, SEARCH_RADIUS_NEAR);
     if (-1 == index) {
         // second attempt to find at position with radius
-        radius = SEARCH_RADIUS_FAR;
-        pixmap.fill(Qt::transparent);
-        index = findWithRadius(painter, pixmap, pos, radius);
+        index = findWithRadius(pos, SEARCH_RADIUS_FAR);
     }
     return index;
 }
 
-int CaptureToolObjects::findWithRadius(QPainter& painter,
-                                       QPixmap& pixmap,
-                                       const QPoint& pos,
-                                       int radius)
+/**
+ * @brief Rebuild the index on the next find, after objects were moved or
+ * resized in place.
+ */
+void CaptureToolObjects::invalidateIndex()
 {
-    int index = m_captureToolObjects.size() - 1;
-    bool useCache = true;
-    m_imageCache.clear();
-    if (m_imageCache.size() != m_captureToolObjects.size() && index >= 0) {
-        // TODO - is not optimal and cache will be used just after first tool
-        // object selecting
-        m_imageCache.clear();
-        useCache = false;
-    }
-    for (; index >= 0; --index) {
-        int currentRadius = radius;
-        QImage image;
-        auto toolItem = m_captureToolObjects.at(index);
-        if (useCache) {
-            image = m_imageCache.at(index);
-        } else {
-            // create transparent image in memory and draw toolItem on it
-            toolItem->drawSearchArea(painter, pixmap);
+    m_indexValid = false;
+}
 
-            // get color at mouse clicked position in area +/- currentRadius
-            image = pixmap.toImage();
-            m_imageCache.insert(0, image);
+void CaptureToolObjects::buildIndex()
+{
+    m_nodes.clear();
+    m_order.clear();
+    m_bounds.resize(m_captureToolObjects.size());
+    for (int i = 0; i < m_captureToolObjects.size(); ++i) {
+        auto toolItem = m_captureToolObjects.at(i);
+        m_bounds[i] = toolItem ? toolItem->boundingRect() : QRect();
+        if (!m_bounds[i].isEmpty()) {
+            m_order.append(i);
         }
+    }
+    if (!m_order.isEmpty()) {
+        buildNode(0, m_order.size());
+    }
+    m_indexValid = true;
+}
 
-        if (toolItem->type() == CaptureTool::TYPE_TEXT) {
-            if (currentRadius > SEARCH_RADIUS_NEAR) {
-                // Text already has a big currentRadius and no need to search
-                // with a bit bigger currentRadius than
-                // SEARCH_RADIUS_TEXT_HANDICAP + SEARCH_RADIUS_NEAR
-                continue;
-            }
+/**
+ * @brief Build the node of the objects `m_order[first, first + count)`,
+ * splitting them in two halves along the longest side of their bounds.
+ * @return The index of the node
+ */
+int CaptureToolObjects::buildNode(int first, int count)
+{
+    Node node;
+    node.first = first;
+    node.count = count;
+    for (int i = first; i < first + count; ++i) {
+        node.bounds = node.bounds.united(m_bounds[m_order[i]]);
+    }
+    int index = m_nodes.size();
+    m_nodes.append(node);
+    if (count <= INDEX_LEAF_SIZE) {
+        return index;
+    }
 
-            // Text has spaces inside to need to take a bigger currentRadius for
-            // text objects search
-            currentRadius += SEARCH_RADIUS_TEXT_HANDICAP;
-        }
+    const bool horizontal = node.bounds.width() >= node.bounds.height();
+    const int half = count / 2;
+    std::nth_element(m_order.begin() + first,
+                     m_order.begin() + first + half,
+                     m_order.begin() + first + count,
+                     [this, horizontal](int a, int b) {
+                         QPoint ca = m_bounds[a].center();
+                         QPoint cb = m_bounds[b].center();
+                         return horizontal ? ca.x() < cb.x() : ca.y() < cb.y();
+                     });
+    int left = buildNode(first, half);
+    int right = buildNode(first + half, count - half);
+    m_nodes[index].left = left;
+    m_nodes[index].right = right;
+    m_nodes[index].count = 0;
+    return index;
+}
 
-        for (int x = pos.x() - currentRadius; x <= pos.x() + currentRadius;
-             ++x) {
-            for (int y = pos.y() - currentRadius; y <= pos.y() + currentRadius;
-                 ++y) {
-                QRgb rgb = image.pixel(x, y);
-                if (rgb != 0) {
-                    // object was found, return it index (layer index)
-                    return index;
+int CaptureToolObjects::findWithRadius(const QPoint& pos, int radius)
+{
+    const QMargins margins(radius, radius, radius, radius);
+    // Objects whose bounds are near pos, only those are tested exactly
+    QVector<int> candidates;
+    QVector<int> stack;
+    if (!m_nodes.isEmpty()) {
+        stack.append(0);
+    }
+    while (!stack.isEmpty()) {
+        const Node& node = m_nodes.at(stack.takeLast());
+        if (!(node.bounds + margins).contains(pos)) {
+            continue;
+        }
+        if (node.left < 0) {
+            for (int i = node.first; i < node.first + node.count; ++i) {
+                if ((m_bounds[m_order[i]] + margins).contains(pos)) {
+                    candidates.append(m_order[i]);
                 }
             }
+        } else {
+            stack.append(node.left);
+            stack.append(node.right);
+        }
+    }
+
+    // the topmost object is selected
+    std::sort(candidates.begin(), candidates.end(), std::greater<int>());
+    for (int index : qAsConst(candidates)) {
+        auto toolItem = m_captureToolObjects.at(index);
+        if (toolItem && toolItem->hitTest(pos, radius)) {
+            return index;
         }
     }
     // no object at current pos found
@@ -158,5 +255,6 @@ CaptureToolObjects& CaptureToolObjects::operator=(
         }
         count++;
     }
+    m_indexValid = false;
     return *this;
 }
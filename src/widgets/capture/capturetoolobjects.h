@@ -7,30 +7,51 @@
 #include "src/tools/capturetool.h"
 #include <QList>
 #include <QPointer>
+#include <QVector>
 
 class CaptureToolObjects : public QObject
 {
 public:
     explicit CaptureToolObjects(QObject* parent = nullptr);
-    QList<QPointer<CaptureTool>> captureToolObjects();
+    QList<QPointer<CaptureTool>> captureToolObjects() const;
     void append(const QPointer<CaptureTool>& captureTool);
     void insert(int index, const QPointer<CaptureTool>& captureTool);
     void removeAt(int index);
+    void replace(int first,
+                 int count,
+                 const QList<QPointer<CaptureTool>>& captureTools);
+    void share(const CaptureToolObjects& other);
+    void detach(int index);
     void clear();
     int size();
-    int find(const QPoint& pos, QSize captureSize);
+    int find(const QPoint& pos);
+    void invalidateIndex();
     QPointer<CaptureTool> at(int index);
     CaptureToolObjects& operator=(const CaptureToolObjects& other);
 
 private:
-    int findWithRadius(QPainter& painter,
-                       QPixmap& pixmap,
-                       const QPoint& pos,
-                       int radius = 0);
+    // A node of the bounding volume hierarchy, either with two children or a
+    // leaf with a range of m_order
+    struct Node
+    {
+        QRect bounds;
+        int left = -1, right = -1;
+        int first = 0, count = 0;
+    };
+
+    void buildIndex();
+    int buildNode(int first, int count);
+    int findWithRadius(const QPoint& pos, int radius);
 
     // class members
     QList<QPointer<CaptureTool>> m_captureToolObjects;
-    QVector<QImage> m_imageCache;
+    // Copies made by detach, owned by this object
+    QList<QPointer<CaptureTool>> m_detached;
+    // Spatial index of the bounding rects of the objects, built by find
+    QVector<Node> m_nodes;
+    QVector<int> m_order;
+    QVector<QRect> m_bounds;
+    bool m_indexValid = false;
 };
 
 #endif // FLAMESHOT_CAPTURETOOLOBJECTS_H
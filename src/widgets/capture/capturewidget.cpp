@@ -33,6 +33,7 @@
 #include <QDateTime>
 #include <QDebug>
 #include <QDesktopWidget>
+#include <QElapsedTimer>
 #include <QFontMetrics>
 #include <QLabel>
 #include <QPaintEvent>
@@ -82,6 +83,8 @@ CaptureWidget::CaptureWidget(const CaptureRequest& req,
 
 {
     m_undoStack.setUndoLimit(ConfigHandler().undoLimit());
+    m_undoStack.setMemoryLimit(qint64(ConfigHandler().undoMemoryLimit()) *
+                               1024 * 1024);
     m_context.circleCount = 1;
 
     // Base config of the widget
@@ -117,6 +120,9 @@ CaptureWidget::CaptureWidget(const CaptureRequest& req,
             this->close();
         }
         m_context.origScreenshot = m_context.screenshot;
+        m_compositor.setBase(m_context.origScreenshot);
+        m_tileCache.setSource(&m_context.screenshot,
+                              QColor(0, 0, 0, m_opacity));
 
 #if defined(Q_OS_WIN)
 // Call cmake with -DFLAMESHOT_DEBUG_CAPTURE=ON to enable easier debugging
@@ -452,6 +458,9 @@ bool CaptureWidget::commitCurrentTool()
 {
     if (m_activeTool) {
         processPixmapWithTool(&m_context.screenshot, m_activeTool);
+        QRect rect = paddedUpdateRect(m_activeTool->boundingRect());
+        m_overlayRect = m_overlayRect.united(rect);
+        m_tileCache.invalidate(rect);
         if (m_activeTool->isValid() && !m_activeTool->editMode() &&
             m_toolWidget) {
             pushToolToStack();
@@ -495,6 +504,7 @@ void CaptureWidget::releaseActiveTool()
             // Object shouldn't be deleted here because it is in the undo/redo
             // stack, just set current pointer to null
             m_activeTool->setEditMode(false);
+            m_captureToolObjects.invalidateIndex();
             if (m_activeTool->isChanged()) {
                 pushObjectsStateToUndoStack();
             }
@@ -524,7 +534,6 @@ void CaptureWidget::uncheckActiveTool()
 
 void CaptureWidget::paintEvent(QPaintEvent* paintEvent)
 {
-    Q_UNUSED(paintEvent)
     QPainter painter(this);
     GeneralConf::xywh_position position =
       static_cast<GeneralConf::xywh_position>(m_config.showSelectionGeometry());
@@ -544,18 +553,19 @@ void CaptureWidget::paintEvent(QPaintEvent* paintEvent)
         painter.save();
         save = true;
     }
-    painter.drawPixmap(0, 0, m_context.screenshot);
+
+    QString xy;
+    QRect xybox;
     if (m_selection && m_xywhDisplay) {
         const QRect& selection = m_selection->geometry().normalized();
         const qreal scale = m_context.screenshot.devicePixelRatio();
-        QRect xybox;
         QFontMetrics fm = painter.fontMetrics();
 
-        QString xy = QString("%1x%2+%3+%4")
-                       .arg(static_cast<int>(selection.width() * scale))
-                       .arg(static_cast<int>(selection.height() * scale))
-                       .arg(static_cast<int>(selection.left() * scale))
-                       .arg(static_cast<int>(selection.top() * scale));
+        xy = QString("%1x%2+%3+%4")
+               .arg(static_cast<int>(selection.width() * scale))
+               .arg(static_cast<int>(selection.height() * scale))
+               .arg(static_cast<int>(selection.left() * scale))
+               .arg(static_cast<int>(selection.top() * scale));
 
         xybox = fm.boundingRect(xy);
         // the small numbers here are just margins so the text doesn't
@@ -589,19 +599,28 @@ void CaptureWidget::paintEvent(QPaintEvent* paintEvent)
                 y0 =
                   selection.top() + (selection.height() - xybox.height()) / 2;
         }
+        xybox.moveTo(x0, y0);
+    }
+
+    // The inactive region is drawn from the cached tiles, except where
+    // something is drawn over the screenshot below, which is dimmed as well
+    const QRegion exposed = paintEvent->region();
+    const QRegion inactive = inactiveRegion() & exposed;
+    const QRegion dimmedLive = inactive & overlayRegion(xybox);
+    const QRegion dimmedCached = inactive - dimmedLive;
+    painter.setClipRegion(exposed - dimmedCached);
+    painter.drawPixmap(0, 0, m_context.screenshot);
+    painter.setClipRegion(dimmedCached);
+    m_tileCache.draw(painter, dimmedCached);
+    painter.setClipping(false);
 
+    if (!xy.isEmpty()) {
         QColor uicolor = ConfigHandler().uiColor();
         uicolor.setAlpha(200);
-        painter.fillRect(
-          x0, y0, xybox.width(), xybox.height(), QBrush(uicolor));
+        painter.fillRect(xybox, QBrush(uicolor));
         painter.setPen(ColorUtils::colorIsDark(uicolor) ? Qt::white
                                                         : Qt::black);
-        painter.drawText(x0,
-                         y0,
-                         xybox.width(),
-                         xybox.height(),
-                         Qt::AlignVCenter | Qt::AlignHCenter,
-                         xy);
+        painter.drawText(xybox, Qt::AlignVCenter | Qt::AlignHCenter, xy);
     }
 
     if (m_displayGrid) {
@@ -628,7 +647,14 @@ void CaptureWidget::paintEvent(QPaintEvent* paintEvent)
     }
 
     if (m_activeTool && m_mouseIsClicked) {
-        m_activeTool->process(painter, m_context.screenshot);
+#if defined(FLAMESHOT_DEBUG_CAPTURE)
+        QElapsedTimer strokeTimer;
+        strokeTimer.start();
+        m_activeTool->drawPreview(painter, m_context.screenshot);
+        drawStrokeCost(painter, strokeTimer.nsecsElapsed());
+#else
+        m_activeTool->drawPreview(painter, m_context.screenshot);
+#endif
     } else if (m_previewEnabled && activeButtonTool() &&
                m_activeButton->tool()->showMousePreview()) {
         m_activeButton->tool()->paintMousePreview(painter, m_context);
@@ -636,7 +662,7 @@ void CaptureWidget::paintEvent(QPaintEvent* paintEvent)
     if (save)
         painter.restore();
     // draw inactive region
-    drawInactiveRegion(&painter);
+    drawInactiveRegion(&painter, dimmedLive);
 
     if (!isActiveWindow()) {
         drawErrorMessage(
@@ -662,7 +688,7 @@ void CaptureWidget::showColorPicker(const QPoint& pos)
 
     // save current state for undo/redo stack
     if (m_panel->activeLayerIndex() >= 0) {
-        m_captureToolObjectsBackup = m_captureToolObjects;
+        backupObjectsState(m_panel->activeLayerIndex());
     }
 
     // Call color picker
@@ -707,6 +733,17 @@ bool CaptureWidget::startDrawObjectTool(const QPoint& pos)
     return false;
 }
 
+/**
+ * @brief Save the state of the objects before a modification, for the undo
+ * stack. The object at `changedIndex` is copied as it is about to be changed
+ * in place, the others are shared with the current state.
+ */
+void CaptureWidget::backupObjectsState(int changedIndex)
+{
+    m_captureToolObjectsBackup.share(m_captureToolObjects);
+    m_captureToolObjectsBackup.detach(changedIndex);
+}
+
 void CaptureWidget::pushObjectsStateToUndoStack()
 {
     m_undoStack.push(new ModificationCommand(
@@ -714,6 +751,24 @@ void CaptureWidget::pushObjectsStateToUndoStack()
     m_captureToolObjectsBackup.clear();
 }
 
+/**
+ * @brief Push the modification of an object in progress (a resize or a move
+ * not released yet), or drop the backup taken for one that didn't happen.
+ *
+ * Called before undo/redo replace objects, which are deleted while the
+ * backup may still share them.
+ */
+void CaptureWidget::settlePendingModification()
+{
+    if (m_existingObjectIsChanged || m_activeToolIsMoved) {
+        m_existingObjectIsChanged = false;
+        m_activeToolIsMoved = false;
+        pushObjectsStateToUndoStack();
+    } else {
+        m_captureToolObjectsBackup.clear();
+    }
+}
+
 int CaptureWidget::selectToolItemAtPos(const QPoint& pos)
 {
     // Try to select existing tool, "-1" - no active tool
@@ -726,7 +781,7 @@ int CaptureWidget::selectToolItemAtPos(const QPoint& pos)
         auto toolItem = activeToolObject();
         if (!toolItem ||
             (toolItem && !toolItem->boundingRect().contains(pos))) {
-            activeLayerIndex = m_captureToolObjects.find(pos, size());
+            activeLayerIndex = m_captureToolObjects.find(pos);
             int oldToolSize = m_context.toolSize;
             m_panel->setActiveLayer(activeLayerIndex);
             drawObjectSelection();
@@ -794,7 +849,7 @@ void CaptureWidget::mouseDoubleClickEvent(QMouseEvent* event)
             m_activeTool = activeTool;
             m_mouseIsClicked = false;
             m_context.mousePos = *m_activeTool->pos();
-            m_captureToolObjectsBackup = m_captureToolObjects;
+            backupObjectsState(activeLayerIndex);
             m_activeTool->setEditMode(true);
             drawToolsData();
             updateLayersPanel();
@@ -856,13 +911,14 @@ void CaptureWidget::mouseMoveEvent(QMouseEvent* e)
             }
             if (!m_activeToolIsMoved) {
                 // save state before movement for undo stack
-                m_captureToolObjectsBackup = m_captureToolObjects;
+                backupObjectsState(m_panel->activeLayerIndex());
             }
             m_activeToolIsMoved = true;
             // update the old region of the selection, margins are added to
             // ensure selection outline is updated too
             update(paddedUpdateRect(activeTool->boundingRect()));
             activeTool->move(e->pos() - m_activeToolOffsetToMouseOnStart);
+            m_captureToolObjects.invalidateIndex();
             drawToolsData();
         }
     } else if (m_activeTool) {
@@ -1389,8 +1445,9 @@ void CaptureWidget::onToolSizeChanged(int t)
     if (toolItem) {
         // Change thickness
         toolItem->onSizeChanged(t);
+        m_captureToolObjects.invalidateIndex();
         if (!m_existingObjectIsChanged) {
-            m_captureToolObjectsBackup = m_captureToolObjects;
+            backupObjectsState(m_panel->activeLayerIndex());
             m_existingObjectIsChanged = true;
         }
         drawToolsData();
@@ -1451,21 +1508,21 @@ void CaptureWidget::updateActiveLayer(int layer)
 
 void CaptureWidget::onMoveCaptureToolUp(int captureToolIndex)
 {
-    m_captureToolObjectsBackup = m_captureToolObjects;
-    pushObjectsStateToUndoStack();
+    backupObjectsState();
     auto tool = m_captureToolObjects.at(captureToolIndex);
     m_captureToolObjects.removeAt(captureToolIndex);
     m_captureToolObjects.insert(captureToolIndex - 1, tool);
+    pushObjectsStateToUndoStack();
     updateLayersPanel();
 }
 
 void CaptureWidget::onMoveCaptureToolDown(int captureToolIndex)
 {
-    m_captureToolObjectsBackup = m_captureToolObjects;
-    pushObjectsStateToUndoStack();
+    backupObjectsState();
     auto tool = m_captureToolObjects.at(captureToolIndex);
     m_captureToolObjects.removeAt(captureToolIndex);
     m_captureToolObjects.insert(captureToolIndex + 1, tool);
+    pushObjectsStateToUndoStack();
     updateLayersPanel();
 }
 
@@ -1485,7 +1542,7 @@ void CaptureWidget::removeToolObject(int index)
         // in case this tool is circle counter
         const CaptureTool::Type currentToolType =
           m_captureToolObjects.at(index)->type();
-        m_captureToolObjectsBackup = m_captureToolObjects;
+        backupObjectsState();
         update(
           paddedUpdateRect(m_captureToolObjects.at(index)->boundingRect()));
         if (currentToolType == CaptureTool::TYPE_CIRCLECOUNT) {
@@ -1499,7 +1556,10 @@ void CaptureWidget::removeToolObject(int index)
                 }
                 auto circleTool = m_captureToolObjects.at(cnt);
                 if (circleTool->count() >= removedCircleCount) {
+                    m_captureToolObjectsBackup.detach(cnt);
                     circleTool->setCount(circleTool->count() - 1);
+                    m_compositor.invalidate(
+                      paddedUpdateRect(circleTool->boundingRect()));
                 }
             }
         }
@@ -1657,8 +1717,36 @@ void CaptureWidget::updateTool(CaptureTool* tool)
 
     oldPreviewRect = previewRect;
     oldToolObjectRect = toolObjectRect;
+#if defined(FLAMESHOT_DEBUG_CAPTURE)
+    update(strokeCostRect());
+#endif
+}
+
+#if defined(FLAMESHOT_DEBUG_CAPTURE)
+QRect CaptureWidget::strokeCostRect() const
+{
+    return QRect(10, 10, 240, fontMetrics().height() + 8);
 }
 
+/**
+ * @brief Show the time taken to draw the object being drawn in the last
+ * frame, to check that it doesn't grow with the object.
+ */
+void CaptureWidget::drawStrokeCost(QPainter& painter, qint64 nsecs)
+{
+    QRect rect = strokeCostRect();
+    painter.save();
+    painter.setOpacity(1);
+    painter.fillRect(rect, QColor(0, 0, 0, 160));
+    painter.setPen(Qt::white);
+    painter.drawText(
+      rect,
+      Qt::AlignCenter,
+      QStringLiteral("Stroke: %1 us").arg(nsecs / 1000.0, 0, 'f', 1));
+    painter.restore();
+}
+#endif
+
 void CaptureWidget::updateLayersPanel()
 {
     m_panel->fillCaptureTools(m_captureToolObjects.captureToolObjects());
@@ -1684,7 +1772,7 @@ void CaptureWidget::pushToolToStack()
         // function again on text objects
         m_panel->blockSignals(true);
 
-        m_captureToolObjectsBackup = m_captureToolObjects;
+        backupObjectsState();
         m_captureToolObjects.append(m_activeTool);
         pushObjectsStateToUndoStack();
         releaseActiveTool();
@@ -1698,15 +1786,21 @@ void CaptureWidget::pushToolToStack()
 
 void CaptureWidget::drawToolsData(bool drawSelection)
 {
-    // TODO refactor this for performance. The objects should not all be updated
-    // at once every time
-    QPixmap pixmapItem = m_context.origScreenshot;
-    for (auto toolItem : m_captureToolObjects.captureToolObjects()) {
-        processPixmapWithTool(&pixmapItem, toolItem);
-        update(paddedUpdateRect(toolItem->boundingRect()));
+    // Only the areas where the objects changed are rendered again, and the
+    // previous object selection is erased
+    QRegion changed = m_compositor.update(
+      m_captureToolObjects.captureToolObjects(), m_panel->activeLayerIndex());
+    changed += m_overlayRect;
+    m_overlayRect = QRect();
+    if (!changed.isEmpty()) {
+        QPainter painter(&m_context.screenshot);
+        painter.setClipRegion(changed);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        painter.drawPixmap(0, 0, m_compositor.result());
+        m_tileCache.invalidate(changed);
+        update(changed);
     }
 
-    m_context.screenshot = pixmapItem;
     if (drawSelection) {
         drawObjectSelection();
     }
@@ -1718,6 +1812,10 @@ void CaptureWidget::drawObjectSelection()
     if (toolItem && !toolItem->editMode()) {
         QPainter painter(&m_context.screenshot);
         toolItem->drawObjectSelection(painter);
+        QRect rect = paddedUpdateRect(toolItem->boundingRect());
+        m_overlayRect = m_overlayRect.united(rect);
+        m_tileCache.invalidate(rect);
+        update(rect);
         // TODO move this elsewhere
         if (m_context.toolSize != toolItem->size()) {
             m_context.toolSize = toolItem->size();
@@ -1829,11 +1927,31 @@ void CaptureWidget::childLeave()
     updateTool(activeButtonTool());
 }
 
-void CaptureWidget::setCaptureToolObjects(
-  const CaptureToolObjects& captureToolObjects)
+/**
+ * @brief Replace `count` objects from `first` with copies of `captureTools`,
+ * used for undo/redo.
+ */
+void CaptureWidget::replaceCaptureToolObjects(
+  int first,
+  int count,
+  const QList<CaptureTool*>& captureTools)
+{
+    for (int i = first; i < first + count; ++i) {
+        auto tool = m_captureToolObjects.at(i);
+        if (tool && tool != m_activeTool) {
+            tool->deleteLater();
+        }
+    }
+    QList<QPointer<CaptureTool>> copies;
+    for (auto* tool : captureTools) {
+        copies.append(tool ? tool->copy(this) : nullptr);
+    }
+    m_captureToolObjects.replace(first, count, copies);
+    refreshCaptureToolObjects();
+}
+
+void CaptureWidget::refreshCaptureToolObjects()
 {
-    // Used for undo/redo
-    m_captureToolObjects = captureToolObjects;
     drawToolsData();
     updateLayersPanel();
     drawObjectSelection();
@@ -1847,10 +1965,8 @@ void CaptureWidget::undo()
         // be called
         m_panel->setActiveLayer(-1);
     }
+    settlePendingModification();
 
-    // drawToolsData is called twice to update both previous and new regions
-    // FIXME this is a temporary workaround
-    drawToolsData();
     m_undoStack.undo();
     drawToolsData();
     updateLayersPanel();
@@ -1860,9 +1976,7 @@ void CaptureWidget::undo()
 
 void CaptureWidget::redo()
 {
-    // drawToolsData is called twice to update both previous and new regions
-    // FIXME this is a temporary workaround
-    drawToolsData();
+    settlePendingModification();
     m_undoStack.redo();
     drawToolsData();
     update();
@@ -1914,17 +2028,46 @@ void CaptureWidget::drawErrorMessage(const QString& msg, QPainter* painter)
     }
 }
 
-void CaptureWidget::drawInactiveRegion(QPainter* painter)
+QRegion CaptureWidget::inactiveRegion() const
 {
-    QColor overlayColor(0, 0, 0, m_opacity);
-    painter->setBrush(overlayColor);
     QRect r;
     if (m_selection->isVisible()) {
         r = m_selection->geometry().normalized();
     }
     QRegion grey(rect());
-    grey = grey.subtracted(r);
+    return grey.subtracted(r);
+}
 
-    painter->setClipRegion(grey);
+/**
+ * @brief The area where paintEvent draws over the screenshot: the tool being
+ * drawn or its mouse preview, the grid and the selection geometry `xybox`.
+ */
+QRegion CaptureWidget::overlayRegion(const QRect& xybox) const
+{
+    QRegion region(xybox);
+    if (m_displayGrid) {
+        const int step = m_gridSize * m_context.screenshot.devicePixelRatio();
+        region += m_context.selection + QMargins(step, step, step, step);
+    }
+    if (m_activeTool && m_mouseIsClicked) {
+        region += paddedUpdateRect(m_activeTool->boundingRect());
+    } else if (m_previewEnabled && activeButtonTool() &&
+               m_activeButton->tool()->showMousePreview()) {
+        // Same margins as the updates of updateTool
+        QRect r = m_activeButton->tool()->mousePreviewRect(m_context);
+        region += r + QMargins(r.width(), r.height(), r.width(), r.height());
+    }
+    return region;
+}
+
+void CaptureWidget::drawInactiveRegion(QPainter* painter,
+                                       const QRegion& region)
+{
+    if (region.isEmpty()) {
+        return;
+    }
+    QColor overlayColor(0, 0, 0, m_opacity);
+    painter->setBrush(overlayColor);
+    painter->setClipRegion(region);
     painter->drawRect(-1, -1, rect().width() + 1, rect().height() + 1);
 }
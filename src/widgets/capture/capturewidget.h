@@ -14,6 +14,9 @@
 #include "buttonhandler.h"
 #include "capturetoolbutton.h"
 #include "capturetoolobjects.h"
+#include "layercompositor.h"
+#include "tilecache.h"
+#include "undostack.h"
 #include "src/config/generalconf.h"
 #include "src/tools/capturecontext.h"
 #include "src/tools/capturetool.h"
@@ -22,7 +25,6 @@
 #include "src/widgets/capture/selectionwidget.h"
 #include <QPointer>
 #include <QTimer>
-#include <QUndoStack>
 #include <QWidget>
 
 class QLabel;
@@ -52,7 +54,10 @@ public:
     ~CaptureWidget();
 
     QPixmap pixmap();
-    void setCaptureToolObjects(const CaptureToolObjects& captureToolObjects);
+    void replaceCaptureToolObjects(int first,
+                                   int count,
+                                   const QList<CaptureTool*>& captureTools);
+    void refreshCaptureToolObjects();
 #if !defined(DISABLE_UPDATE_CHECKER)
     void showAppUpdateNotification(const QString& appLatestVersion,
                                    const QString& appLatestUrl);
@@ -108,7 +113,9 @@ protected:
     void changeEvent(QEvent* changeEvent) override;
 
 private:
+    void backupObjectsState(int changedIndex = -1);
     void pushObjectsStateToUndoStack();
+    void settlePendingModification();
     void releaseActiveTool();
     void uncheckActiveTool();
     int selectToolItemAtPos(const QPoint& pos);
@@ -140,7 +147,13 @@ private:
     QRect extendedRect(const QRect& r) const;
     QRect paddedUpdateRect(const QRect& r) const;
     void drawErrorMessage(const QString& msg, QPainter* painter);
-    void drawInactiveRegion(QPainter* painter);
+    QRegion inactiveRegion() const;
+    QRegion overlayRegion(const QRect& xybox) const;
+    void drawInactiveRegion(QPainter* painter, const QRegion& region);
+#if defined(FLAMESHOT_DEBUG_CAPTURE)
+    QRect strokeCostRect() const;
+    void drawStrokeCost(QPainter& painter, qint64 nsecs);
+#endif
     void drawToolsData(bool drawSelection = true);
     void drawObjectSelection();
 
@@ -203,6 +216,11 @@ private:
     QMap<CaptureTool::Type, CaptureTool*> m_tools;
     CaptureToolObjects m_captureToolObjects;
     CaptureToolObjects m_captureToolObjectsBackup;
+    LayerCompositor m_compositor;
+    TileCache m_tileCache;
+    // Area of m_context.screenshot drawn over the composited objects, e.g.
+    // the object selection, restored by drawToolsData
+    QRect m_overlayRect;
 
     QPoint m_mousePressedPos;
     QPoint m_activeToolOffsetToMouseOnStart;
@@ -211,7 +229,7 @@ private:
     bool m_xywhDisplay;
     QTimer m_xywhTimer;
 
-    QUndoStack m_undoStack;
+    UndoStack m_undoStack;
 
     bool m_existingObjectIsChanged;
 
@@ -0,0 +1,238 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "layercompositor.h"
+#include <QPainter>
+
+namespace {
+
+// The bounding rect of some objects doesn't include their pen or
+// antialiasing, the same margin as for the widget updates is added
+const int boundsMargin = 20;
+
+QRect paddedBounds(const CaptureTool* tool)
+{
+    QRect r = tool->boundingRect();
+    return r.isNull() ? r : r + QMargins(boundsMargin,
+                                         boundsMargin,
+                                         boundsMargin,
+                                         boundsMargin);
+}
+
+void processObject(QPainter& painter, const QPixmap& pixmap, CaptureTool* tool)
+{
+    painter.save();
+    painter.setRenderHint(QPainter::Antialiasing);
+    tool->process(painter, pixmap);
+    painter.restore();
+}
+
+} // namespace
+
+void LayerCompositor::setBase(const QPixmap& base)
+{
+    m_base = base;
+    m_result = base;
+    m_prefix = QPixmap();
+    m_prefixSize = 0;
+    m_layers.clear();
+    m_active = nullptr;
+    m_dirty = QRegion();
+}
+
+/**
+ * @brief Mark `rect` to be rendered again on the next update, for objects
+ * changed in place that aren't selected, e.g. renumbered circle counters.
+ */
+void LayerCompositor::invalidate(const QRect& rect)
+{
+    m_dirty += rect;
+}
+
+/**
+ * @brief Render `objects` onto the base pixmap, `activeIndex` being the
+ * selected one or -1.
+ * @return The area of `result` that changed
+ */
+QRegion LayerCompositor::update(const QList<QPointer<CaptureTool>>& objects,
+                                int activeIndex)
+{
+    if (m_base.isNull()) {
+        return {};
+    }
+    const CaptureTool* active = nullptr;
+    if (activeIndex >= 0 && activeIndex < objects.size()) {
+        active = objects[activeIndex];
+    }
+
+    QRegion dirty;
+    int first = diff(objects, active, dirty);
+    if (!m_dirty.isEmpty()) {
+        for (int i = 0; i < first; ++i) {
+            if (objects[i] && m_dirty.intersects(paddedBounds(objects[i]))) {
+                first = i;
+                break;
+            }
+        }
+        dirty += m_dirty;
+        m_dirty = QRegion();
+    }
+
+    m_layers.clear();
+    m_layers.reserve(objects.size());
+    for (const auto& tool : objects) {
+        m_layers.append({ tool.data(), tool ? paddedBounds(tool) : QRect() });
+    }
+    m_active = active;
+    if (m_prefixSize > first) {
+        m_prefix = QPixmap();
+        m_prefixSize = 0;
+    }
+    if (dirty.isEmpty()) {
+        return dirty;
+    }
+
+    if (activeIndex > 0 && active != nullptr) {
+        updatePrefix(objects, activeIndex);
+        render(objects, activeIndex, m_prefix, dirty);
+    } else {
+        render(objects, 0, m_base, dirty);
+    }
+    return dirty;
+}
+
+/**
+ * @brief The base pixmap with all the objects of the last update.
+ */
+const QPixmap& LayerCompositor::result() const
+{
+    return m_result;
+}
+
+/**
+ * @brief Add to `dirty` the areas where `objects` differ from the previous
+ * update.
+ * @return The index of the first object that may render differently
+ */
+int LayerCompositor::diff(const QList<QPointer<CaptureTool>>& objects,
+                          const CaptureTool* active,
+                          QRegion& dirty) const
+{
+    const int size = objects.size();
+    int same = 0;
+    while (same < size && same < m_layers.size() &&
+           objects[same].data() == m_layers[same].tool.data()) {
+        ++same;
+    }
+    int first = (same < size || same < m_layers.size()) ? same : size;
+
+    QHash<const CaptureTool*, int> oldIndex, newIndex;
+    for (int i = 0; i < m_layers.size(); ++i) {
+        if (m_layers[i].tool) {
+            oldIndex.insert(m_layers[i].tool.data(), i);
+        }
+    }
+    for (int i = 0; i < size; ++i) {
+        if (objects[i]) {
+            newIndex.insert(objects[i], i);
+        }
+    }
+    // The old indexes of the objects still there, to find the ones whose
+    // order changed
+    QVector<int> kept;
+    for (int i = 0; i < m_layers.size(); ++i) {
+        // The objects deleted since are gone from the list as well
+        if (!m_layers[i].tool) {
+            dirty += m_layers[i].bounds;
+            continue;
+        }
+        if (newIndex.contains(m_layers[i].tool.data())) {
+            kept.append(i);
+        } else {
+            dirty += m_layers[i].bounds;
+        }
+    }
+
+    int keptIndex = 0;
+    for (int i = 0; i < size; ++i) {
+        const CaptureTool* tool = objects[i];
+        if (!tool) {
+            continue;
+        }
+        QRect bounds = paddedBounds(tool);
+        auto it = oldIndex.constFind(tool);
+        if (it == oldIndex.constEnd()) {
+            dirty += bounds;
+            first = qMin(first, i);
+            continue;
+        }
+        const Layer& layer = m_layers[it.value()];
+        bool reordered = kept[keptIndex++] != it.value();
+        if (reordered || layer.bounds != bounds || tool == active ||
+            tool == m_active.data()) {
+            dirty += layer.bounds;
+            dirty += bounds;
+            first = qMin(first, i);
+        }
+    }
+    return first;
+}
+
+/**
+ * @brief Flatten the first `size` objects into the prefix, reusing what it
+ * already holds.
+ */
+void LayerCompositor::updatePrefix(const QList<QPointer<CaptureTool>>& objects,
+                                   int size)
+{
+    if (m_prefix.isNull() || m_prefixSize > size) {
+        m_prefix = m_base;
+        m_prefixSize = 0;
+    }
+    if (m_prefixSize == size) {
+        return;
+    }
+    QPainter painter(&m_prefix);
+    for (int i = m_prefixSize; i < size; ++i) {
+        if (objects[i]) {
+            processObject(painter, m_prefix, objects[i]);
+        }
+    }
+    m_prefixSize = size;
+}
+
+/**
+ * @brief Restore `dirty` from `source`, which has the objects before
+ * `first` flattened, and process the objects from `first` on in it.
+ */
+void LayerCompositor::render(const QList<QPointer<CaptureTool>>& objects,
+                             int first,
+                             const QPixmap& source,
+                             QRegion& dirty)
+{
+    // Tools reading the capture, e.g. pixelate, need the whole area they
+    // read to be up to date, not only the part of it that is dirty
+    for (bool grown = true; grown;) {
+        grown = false;
+        for (int i = first; i < objects.size(); ++i) {
+            const QRect& bounds = m_layers[i].bounds;
+            if (objects[i] && objects[i]->readsPixmap() &&
+                dirty.intersects(bounds) &&
+                !(QRegion(bounds) - dirty).isEmpty()) {
+                dirty += bounds;
+                grown = true;
+            }
+        }
+    }
+
+    QPainter painter(&m_result);
+    painter.setClipRegion(dirty);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.drawPixmap(0, 0, source);
+    painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+    for (int i = first; i < objects.size(); ++i) {
+        if (objects[i] && dirty.intersects(m_layers[i].bounds)) {
+            processObject(painter, m_result, objects[i]);
+        }
+    }
+}
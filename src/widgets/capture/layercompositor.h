@@ -0,0 +1,65 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include "src/tools/capturetool.h"
+#include <QHash>
+#include <QList>
+#include <QPixmap>
+#include <QPointer>
+#include <QRegion>
+#include <QVector>
+
+/**
+ * @brief Flattens the capture tool objects onto the screenshot, rendering
+ * again only what changed since the previous call.
+ *
+ * The objects passed to `update` are compared with the ones of the previous
+ * call: the areas of the added, removed, moved, resized and reordered
+ * objects are dirty, as well as the one of the selected object (and of the
+ * previously selected one), whose color, size or text may have changed in
+ * place. Only the objects intersecting the dirty area are processed again,
+ * clipped to it.
+ *
+ * The objects below the selected one can't change while it is edited, so
+ * they are flattened once into a prefix bitmap which dirty areas are
+ * restored from, instead of processing them again at each step.
+ */
+class LayerCompositor
+{
+public:
+    void setBase(const QPixmap& base);
+    void invalidate(const QRect& rect);
+    QRegion update(const QList<QPointer<CaptureTool>>& objects,
+                   int activeIndex);
+    const QPixmap& result() const;
+
+private:
+    // The objects are compared by address, a guarded pointer doesn't take
+    // a deleted one for a new object allocated at the same address
+    struct Layer
+    {
+        QPointer<const CaptureTool> tool;
+        QRect bounds;
+    };
+
+    int diff(const QList<QPointer<CaptureTool>>& objects,
+             const CaptureTool* active,
+             QRegion& dirty) const;
+    void updatePrefix(const QList<QPointer<CaptureTool>>& objects, int size);
+    void render(const QList<QPointer<CaptureTool>>& objects,
+                int first,
+                const QPixmap& source,
+                QRegion& dirty);
+
+    QPixmap m_base;
+    QPixmap m_result;
+    // m_base with the first m_prefixSize objects flattened, or null
+    QPixmap m_prefix;
+    int m_prefixSize = 0;
+    // The objects as of the previous update
+    QVector<Layer> m_layers;
+    QPointer<const CaptureTool> m_active;
+    QRegion m_dirty;
+};
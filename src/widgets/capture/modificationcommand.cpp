@@ -4,22 +4,83 @@
 #include "modificationcommand.h"
 #include "capturewidget.h"
 
+namespace {
+
+QList<CaptureTool*> copyRange(const QList<QPointer<CaptureTool>>& objects,
+                              int first,
+                              int last)
+{
+    QList<CaptureTool*> copies;
+    for (int i = first; i < last; ++i) {
+        // Null objects are kept, the range must keep its size and positions
+        copies.append(objects[i] ? objects[i]->copy() : nullptr);
+    }
+    return copies;
+}
+
+} // namespace
+
 ModificationCommand::ModificationCommand(
   CaptureWidget* captureWidget,
   const CaptureToolObjects& captureToolObjects,
   const CaptureToolObjects& captureToolObjectsBackup)
   : m_captureWidget(captureWidget)
 {
-    m_captureToolObjects = captureToolObjects;
-    m_captureToolObjectsBackup = captureToolObjectsBackup;
+    // The backup shares the objects that didn't change with the current
+    // state, the range between the common start and end is what changed
+    const auto after = captureToolObjects.captureToolObjects();
+    const auto before = captureToolObjectsBackup.captureToolObjects();
+    const int size = qMin(after.size(), before.size());
+    while (m_first < size && after[m_first] == before[m_first]) {
+        ++m_first;
+    }
+    int common = 0;
+    while (common < size - m_first &&
+           after[after.size() - 1 - common] ==
+             before[before.size() - 1 - common]) {
+        ++common;
+    }
+    m_before = copyRange(before, m_first, before.size() - common);
+    m_after = copyRange(after, m_first, after.size() - common);
+}
+
+ModificationCommand::~ModificationCommand()
+{
+    qDeleteAll(m_before);
+    qDeleteAll(m_after);
 }
 
 void ModificationCommand::undo()
 {
-    m_captureWidget->setCaptureToolObjects(m_captureToolObjectsBackup);
+    m_captureWidget->replaceCaptureToolObjects(
+      m_first, m_after.size(), m_before);
 }
 
 void ModificationCommand::redo()
 {
-    m_captureWidget->setCaptureToolObjects(m_captureToolObjects);
+    // The first redo is the push to the undo stack, the widget already has
+    // these objects. Keeping them, rather than copies, lets it render only
+    // what changed.
+    if (m_pushed) {
+        m_pushed = false;
+        m_captureWidget->refreshCaptureToolObjects();
+        return;
+    }
+    m_captureWidget->replaceCaptureToolObjects(
+      m_first, m_before.size(), m_after);
+}
+
+/**
+ * @brief Approximate memory held by the command in bytes.
+ */
+qint64 ModificationCommand::memoryUsage() const
+{
+    qint64 usage = sizeof(*this);
+    for (const auto* tool : m_before) {
+        usage += tool ? tool->memoryUsage() : 0;
+    }
+    for (const auto* tool : m_after) {
+        usage += tool ? tool->memoryUsage() : 0;
+    }
+    return usage;
 }
@@ -2,27 +2,42 @@
 // SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
 
 #include "capturetoolobjects.h"
-#include <QUndoCommand>
 
 #ifndef FLAMESHOT_MODIFICATIONCOMMAND_H
 #define FLAMESHOT_MODIFICATIONCOMMAND_H
 
 class CaptureWidget;
 
-class ModificationCommand : public QUndoCommand
+/**
+ * @brief A change of the capture tool objects, as the range of objects that
+ * differs between the states before and after it.
+ *
+ * The objects at the start and at the end of both states that are the same
+ * are not stored, so adding, removing, editing or reordering an object only
+ * keeps copies of the one or two objects involved.
+ */
+class ModificationCommand
 {
 public:
     ModificationCommand(CaptureWidget* captureWidget,
                         const CaptureToolObjects& captureToolObjects,
                         const CaptureToolObjects& captureToolObjectsBackup);
+    ~ModificationCommand();
 
-    virtual void undo() override;
-    virtual void redo() override;
+    void undo();
+    void redo();
+    qint64 memoryUsage() const;
 
 private:
-    CaptureToolObjects m_captureToolObjects;
-    CaptureToolObjects m_captureToolObjectsBackup;
+    Q_DISABLE_COPY(ModificationCommand)
+
     CaptureWidget* m_captureWidget;
+    // Index of the first changed object
+    int m_first = 0;
+    // Copies of the changed objects, before and after the change
+    QList<CaptureTool*> m_before;
+    QList<CaptureTool*> m_after;
+    bool m_pushed = true;
 };
 
 #endif // FLAMESHOT_MODIFICATIONCOMMAND_H
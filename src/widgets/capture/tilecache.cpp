@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "tilecache.h"
+#include <QPainter>
+
+/**
+ * @brief Cache tiles of `source` with `overlay` over them. `source` is
+ * painted on in place, the changed areas must be invalidated.
+ */
+void TileCache::setSource(const QPixmap* source, const QColor& overlay)
+{
+    m_source = source;
+    m_overlay = overlay;
+    m_size = (QSizeF(source->size()) / source->devicePixelRatio()).toSize();
+    m_columns = (m_size.width() + tileSize - 1) / tileSize;
+    m_rows = (m_size.height() + tileSize - 1) / tileSize;
+    m_tiles = QVector<QPixmap>(m_columns * m_rows);
+    m_dirty = QVector<bool>(m_columns * m_rows, true);
+}
+
+void TileCache::invalidate(const QRegion& region)
+{
+    for (const QRect& rect : region) {
+        QRect r = rect.intersected(QRect(QPoint(0, 0), m_size));
+        if (r.isEmpty()) {
+            continue;
+        }
+        for (int row = r.top() / tileSize; row <= r.bottom() / tileSize;
+             ++row) {
+            for (int column = r.left() / tileSize;
+                 column <= r.right() / tileSize;
+                 ++column) {
+                m_dirty[row * m_columns + column] = true;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Draw the tiles intersecting `region`, which the painter should be
+ * clipped to.
+ */
+void TileCache::draw(QPainter& painter, const QRegion& region)
+{
+    QRect bounds =
+      region.boundingRect().intersected(QRect(QPoint(0, 0), m_size));
+    if (bounds.isEmpty()) {
+        return;
+    }
+    for (int row = bounds.top() / tileSize; row <= bounds.bottom() / tileSize;
+         ++row) {
+        for (int column = bounds.left() / tileSize;
+             column <= bounds.right() / tileSize;
+             ++column) {
+            QRect rect = tileRect(column, row);
+            if (region.intersects(rect)) {
+                painter.drawPixmap(rect.topLeft(), tile(column, row));
+            }
+        }
+    }
+}
+
+QRect TileCache::tileRect(int column, int row) const
+{
+    return QRect(column * tileSize, row * tileSize, tileSize, tileSize)
+      .intersected(QRect(QPoint(0, 0), m_size));
+}
+
+const QPixmap& TileCache::tile(int column, int row)
+{
+    const int index = row * m_columns + column;
+    QPixmap& tile = m_tiles[index];
+    if (!m_dirty[index]) {
+        return tile;
+    }
+
+    const QRect rect = tileRect(column, row);
+    const qreal scale = m_source->devicePixelRatio();
+    const QSize deviceSize = (QSizeF(rect.size()) * scale).toSize();
+    if (tile.size() != deviceSize) {
+        tile = QPixmap(deviceSize);
+        tile.setDevicePixelRatio(scale);
+    }
+    QPainter painter(&tile);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.drawPixmap(QRectF(QPointF(0, 0), rect.size()),
+                       *m_source,
+                       QRectF(QPointF(rect.topLeft()) * scale,
+                              QSizeF(rect.size()) * scale));
+    painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+    painter.fillRect(QRect(QPoint(0, 0), rect.size()), m_overlay);
+    m_dirty[index] = false;
+    return tile;
+}
@@ -0,0 +1,42 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include <QColor>
+#include <QPixmap>
+#include <QRegion>
+#include <QVector>
+
+class QPainter;
+
+/**
+ * @brief The screenshot with the overlay of the inactive region painted
+ * over it, split in tiles which are built when first drawn and again only
+ * after they are invalidated.
+ *
+ * Repainting the inactive region is then a copy of the exposed part of a
+ * few tiles, rather than blending the overlay over it each time.
+ */
+class TileCache
+{
+public:
+    // Logical pixels, a whole number of device pixels at the usual scales
+    static const int tileSize = 256;
+
+    void setSource(const QPixmap* source, const QColor& overlay);
+    void invalidate(const QRegion& region);
+    void draw(QPainter& painter, const QRegion& region);
+
+private:
+    QRect tileRect(int column, int row) const;
+    const QPixmap& tile(int column, int row);
+
+    const QPixmap* m_source = nullptr;
+    QColor m_overlay;
+    QSize m_size;
+    int m_columns = 0;
+    int m_rows = 0;
+    QVector<QPixmap> m_tiles;
+    QVector<bool> m_dirty;
+};
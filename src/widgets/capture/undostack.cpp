@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "undostack.h"
+#include "modificationcommand.h"
+
+UndoStack::~UndoStack()
+{
+    qDeleteAll(m_commands);
+}
+
+/**
+ * @brief Add `command` after the ones done, which replaces the ones that
+ * could be redone, and do it.
+ */
+void UndoStack::push(ModificationCommand* command)
+{
+    while (m_commands.size() > m_index) {
+        ModificationCommand* last = m_commands.takeLast();
+        m_memoryUsage -= last->memoryUsage();
+        delete last;
+    }
+    command->redo();
+    m_commands.append(command);
+    m_memoryUsage += command->memoryUsage();
+    ++m_index;
+    trim();
+}
+
+void UndoStack::undo()
+{
+    if (m_index > 0) {
+        m_commands[--m_index]->undo();
+    }
+}
+
+void UndoStack::redo()
+{
+    if (m_index < m_commands.size()) {
+        m_commands[m_index++]->redo();
+    }
+}
+
+/**
+ * @brief Keep at most `limit` commands, 0 for no limit.
+ */
+void UndoStack::setUndoLimit(int limit)
+{
+    m_undoLimit = limit;
+    trim();
+}
+
+/**
+ * @brief Keep the commands within `bytes` of memory, 0 for no limit. The
+ * last command is kept even if it is larger.
+ */
+void UndoStack::setMemoryLimit(qint64 bytes)
+{
+    m_memoryLimit = bytes;
+    trim();
+}
+
+qint64 UndoStack::memoryUsage() const
+{
+    return m_memoryUsage;
+}
+
+/**
+ * @brief Drop the oldest commands while the stack is over its limits.
+ */
+void UndoStack::trim()
+{
+    while (m_commands.size() > 1 && m_index > 0 &&
+           ((m_undoLimit > 0 && m_commands.size() > m_undoLimit) ||
+            (m_memoryLimit > 0 && m_memoryUsage > m_memoryLimit))) {
+        ModificationCommand* first = m_commands.takeFirst();
+        m_memoryUsage -= first->memoryUsage();
+        delete first;
+        --m_index;
+    }
+}
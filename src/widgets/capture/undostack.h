@@ -0,0 +1,42 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include <QList>
+
+class ModificationCommand;
+
+/**
+ * @brief The undo/redo history of the capture tool objects.
+ *
+ * Unlike QUndoStack, the oldest commands are dropped when the history goes
+ * over its limits, which are a number of commands and the memory held by
+ * them.
+ */
+class UndoStack
+{
+public:
+    UndoStack() = default;
+    ~UndoStack();
+
+    void push(ModificationCommand* command);
+    void undo();
+    void redo();
+    void setUndoLimit(int limit);
+    void setMemoryLimit(qint64 bytes);
+    qint64 memoryUsage() const;
+
+private:
+    Q_DISABLE_COPY(UndoStack)
+
+    void trim();
+
+    QList<ModificationCommand*> m_commands;
+    // Number of commands done, the ones after it can be redone
+    int m_index = 0;
+    // 0 for no limit
+    int m_undoLimit = 0;
+    qint64 m_memoryLimit = 0;
+    qint64 m_memoryUsage = 0;
+};
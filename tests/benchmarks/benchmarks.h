@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include <QImage>
+#include <QObject>
+
+// The size of the captures measured, an 8K screen
+const QSize benchmarkSize(7680, 4320);
+
+/**
+ * @brief `ImageScaler` against the smooth scaling of `QPixmap`, downscaling
+ * to half the size.
+ */
+class ScalerBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void imageScaler();
+    void pixmapScaled();
+
+private:
+    QImage m_image;
+};
+
+/**
+ * @brief Reading the capture of a 7680x2160 desktop from grim, as PNG or as
+ * PPM.
+ */
+class TransportBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void png();
+    void ppm();
+
+private:
+    QByteArray m_png;
+    QByteArray m_ppm;
+};
+
+/**
+ * @brief Copying a capture to the clipboard as PNG through `ImageMimeData`,
+ * against encoding it right away and decoding it again to check it.
+ */
+class ClipboardBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void decodeToVerify();
+    void imageMimeData();
+    void pasteAgain();
+
+private:
+    QImage m_image;
+};
+
+#ifdef USE_PARALLEL_PNG
+/**
+ * @brief `PngEncoder` with both filters against `QImageWriter`, at the
+ * default compression level.
+ */
+class PngBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void pngEncoder_data();
+    void pngEncoder();
+    void imageWriter();
+
+private:
+    QImage m_image;
+};
+#endif
+
+#ifdef USE_PARALLEL_JPEG
+/**
+ * @brief `JpegEncoder` against `QImageWriter`, at the default quality.
+ */
+class JpegBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void jpegEncoder();
+    void imageWriter();
+
+private:
+    QImage m_image;
+};
+#endif
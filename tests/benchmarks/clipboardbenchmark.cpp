@@ -0,0 +1,71 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "benchmarks.h"
+#include "src/utils/encodedcapture.h"
+#include "src/utils/imagemimedata.h"
+#include "tests/unit/sampleimage.h"
+#include <QBuffer>
+#include <QImageWriter>
+#include <QMimeData>
+#include <QPixmap>
+#include <QtTest>
+
+namespace {
+
+const QString pngMimeType = QStringLiteral("image/png");
+
+} // namespace
+
+void ClipboardBenchmark::initTestCase()
+{
+    m_image = sampleCapture(benchmarkSize);
+}
+
+/**
+ * The former path, as a baseline: the capture was encoded right away, the
+ * encoded image was decoded again to check it, and converted back to an
+ * image for KSystemClipboard.
+ */
+void ClipboardBenchmark::decodeToVerify()
+{
+    QBENCHMARK
+    {
+        QByteArray data;
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        QVERIFY(QImageWriter(&buffer, "png").write(m_image));
+        QPixmap pixmap;
+        QVERIFY(pixmap.loadFromData(data, "PNG"));
+        QMimeData mimeData;
+        mimeData.setImageData(pixmap.toImage());
+        mimeData.setData(pngMimeType, data);
+    }
+}
+
+/**
+ * The current path: the capture is offered as it is, and encoded with the
+ * configured settings once a client pastes it.
+ */
+void ClipboardBenchmark::imageMimeData()
+{
+    QBENCHMARK
+    {
+        // A new capture each time, the encoding is cached in it
+        ImageMimeData mimeData(EncodedCapture(m_image), "png");
+        QVERIFY(!mimeData.data(pngMimeType).isEmpty());
+    }
+}
+
+/**
+ * Pasting again, or into another client, the encoding is reused.
+ */
+void ClipboardBenchmark::pasteAgain()
+{
+    ImageMimeData mimeData(EncodedCapture(m_image), "png");
+    QVERIFY(!mimeData.data(pngMimeType).isEmpty());
+    QBENCHMARK
+    {
+        QVERIFY(!mimeData.data(pngMimeType).isEmpty());
+    }
+}
@@ -0,0 +1,45 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "benchmarks.h"
+#include "src/utils/jpegencoder.h"
+#include "tests/unit/sampleimage.h"
+#include <QBuffer>
+#include <QImageWriter>
+#include <QtTest>
+
+namespace {
+
+// The default of the jpegQuality setting
+const int quality = 75;
+
+} // namespace
+
+void JpegBenchmark::initTestCase()
+{
+    m_image = sampleCapture(benchmarkSize);
+}
+
+void JpegBenchmark::jpegEncoder()
+{
+    QBENCHMARK
+    {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        JpegEncoder encoder(&buffer);
+        encoder.setQuality(quality);
+        QVERIFY(encoder.write(m_image));
+    }
+}
+
+void JpegBenchmark::imageWriter()
+{
+    QBENCHMARK
+    {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        QImageWriter writer(&buffer, "jpeg");
+        writer.setQuality(quality);
+        QVERIFY(writer.write(m_image));
+    }
+}
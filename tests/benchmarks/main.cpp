@@ -0,0 +1,37 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "benchmarks.h"
+#include <QApplication>
+#include <QtTest>
+
+/**
+ * Runs the benchmarks of every component built in, e.g.
+ * `flameshot-benchmarks -iterations 5`.
+ */
+int main(int argc, char* argv[])
+{
+    // Pixmaps need a platform plugin, but no display. The export path of the
+    // application expects a QApplication.
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+
+    int status = 0;
+    ScalerBenchmark scaler;
+    status |= QTest::qExec(&scaler, argc, argv);
+    TransportBenchmark transport;
+    status |= QTest::qExec(&transport, argc, argv);
+    ClipboardBenchmark clipboard;
+    status |= QTest::qExec(&clipboard, argc, argv);
+#ifdef USE_PARALLEL_PNG
+    PngBenchmark png;
+    status |= QTest::qExec(&png, argc, argv);
+#endif
+#ifdef USE_PARALLEL_JPEG
+    JpegBenchmark jpeg;
+    status |= QTest::qExec(&jpeg, argc, argv);
+#endif
+    return status;
+}
@@ -0,0 +1,55 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "benchmarks.h"
+#include "src/utils/pngencoder.h"
+#include "tests/unit/sampleimage.h"
+#include <QBuffer>
+#include <QImageWriter>
+#include <QtTest>
+
+namespace {
+
+// The default of the pngCompressionLevel setting
+const int level = 6;
+
+} // namespace
+
+void PngBenchmark::initTestCase()
+{
+    m_image = sampleCapture(benchmarkSize);
+}
+
+void PngBenchmark::pngEncoder_data()
+{
+    QTest::addColumn<bool>("fast");
+
+    QTest::newRow("adaptive") << false;
+    QTest::newRow("fast") << true;
+}
+
+void PngBenchmark::pngEncoder()
+{
+    QFETCH(bool, fast);
+    QBENCHMARK
+    {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        PngEncoder encoder(&buffer);
+        encoder.setCompressionLevel(level);
+        encoder.setFilter(fast ? PngEncoder::Fast : PngEncoder::Adaptive);
+        QVERIFY(encoder.write(m_image));
+    }
+}
+
+void PngBenchmark::imageWriter()
+{
+    QBENCHMARK
+    {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        QImageWriter writer(&buffer, "png");
+        writer.setCompression(level);
+        QVERIFY(writer.write(m_image));
+    }
+}
@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "benchmarks.h"
+#include "src/utils/imagescaler.h"
+#include "tests/unit/sampleimage.h"
+#include <QPixmap>
+#include <QtTest>
+
+void ScalerBenchmark::initTestCase()
+{
+    m_image = sampleCapture(benchmarkSize);
+}
+
+void ScalerBenchmark::imageScaler()
+{
+    QBENCHMARK
+    {
+        QImage result = ImageScaler::scaled(m_image, benchmarkSize / 2);
+        QVERIFY(!result.isNull());
+    }
+}
+
+void ScalerBenchmark::pixmapScaled()
+{
+    // Converted once, as the capture is already a pixmap
+    const QPixmap pixmap = QPixmap::fromImage(m_image);
+    QBENCHMARK
+    {
+        QPixmap result = pixmap.scaled(benchmarkSize / 2,
+                                       Qt::IgnoreAspectRatio,
+                                       Qt::SmoothTransformation);
+        QVERIFY(!result.isNull());
+    }
+}
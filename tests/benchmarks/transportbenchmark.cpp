@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "benchmarks.h"
+#include "src/utils/ppmreader.h"
+#include "tests/unit/sampleimage.h"
+#include <QBuffer>
+#include <QImageWriter>
+#include <QtTest>
+
+namespace {
+
+// Two 4K screens side by side
+const QSize desktopSize(7680, 2160);
+
+} // namespace
+
+/**
+ * The output of grim is prepared once in both formats: PNG at its default
+ * compression level, which flameshot used to decode, and PPM.
+ */
+void TransportBenchmark::initTestCase()
+{
+    const QImage desktop =
+      sampleCapture(desktopSize).convertToFormat(QImage::Format_RGB888);
+
+    QBuffer png(&m_png);
+    png.open(QIODevice::WriteOnly);
+    QImageWriter writer(&png, "png");
+    writer.setCompression(6);
+    QVERIFY(writer.write(desktop));
+
+    m_ppm = QStringLiteral("P6\n%1 %2\n255\n")
+              .arg(desktop.width())
+              .arg(desktop.height())
+              .toLatin1();
+    for (int y = 0; y < desktop.height(); ++y) {
+        m_ppm.append(reinterpret_cast<const char*>(desktop.constScanLine(y)),
+                     desktop.width() * 3);
+    }
+}
+
+void TransportBenchmark::png()
+{
+    QBENCHMARK
+    {
+        QImage image = QImage::fromData(m_png, "PNG");
+        QCOMPARE(image.size(), desktopSize);
+    }
+}
+
+void TransportBenchmark::ppm()
+{
+    QBENCHMARK
+    {
+        QBuffer buffer(&m_ppm);
+        buffer.open(QIODevice::ReadOnly);
+        PpmReader reader;
+        QVERIFY(reader.read(&buffer));
+        QCOMPARE(reader.image().size(), desktopSize);
+    }
+}
@@ -0,0 +1,62 @@
+#!/usr/bin/env sh
+
+# Tests for the portal ScreenCast capture backend
+# Arguments:
+# 1. path to tested flameshot executable (built with USE_PORTAL_SCREENCAST)
+
+# Dependencies:
+# - pipewire and wireplumber
+# - xdg-desktop-portal with a backend providing ScreenCast (e.g. the test
+#   backend of xdg-desktop-portal, or the GNOME or KDE one)
+# - identify (imagemagick)
+
+# HOW TO USE:
+# - Run in a GNOME or KDE Wayland session, or in a session bus where the
+#   portal and pipewire are running, with XDG_CURRENT_DESKTOP set accordingly.
+# - The session is hosted by the daemon started below: the permission dialog
+#   must be shown only for the first capture, the following commands must get
+#   their capture from the daemon without asking again. The script exits with
+#   an error if a capture is missing or not faster than the first one.
+
+[ -n "$1" ] && flameshot="$1" || flameshot='flameshot'
+tmp_dir=$(mktemp -d)
+trap 'kill $daemon_pid; rm -rf "$tmp_dir"' EXIT
+
+"$flameshot" &
+daemon_pid=$!
+sleep 2
+
+failed=0
+first=0
+
+for i in 1 2 3; do
+    echo ">> Capture $i"
+    start=$(date +%s%N)
+    "$flameshot" full -p "$tmp_dir/capture$i.png"
+    end=$(date +%s%N)
+    elapsed=$(((end - start) / 1000000))
+
+    size=$(identify -format "%wx%h" "$tmp_dir/capture$i.png" 2>/dev/null)
+    if [ -z "$size" ]; then
+        echo "FAIL: no capture"
+        failed=1
+        continue
+    fi
+    echo "OK:   $size in $elapsed ms"
+
+    # Without a persistent session in the daemon each command would open its
+    # own, and wait for the dialog again
+    if [ "$i" -eq 1 ]; then
+        first=$elapsed
+    elif [ "$elapsed" -ge "$first" ]; then
+        echo "FAIL: not faster than the first capture, was the session reused?"
+        failed=1
+    fi
+done
+
+if [ $failed -eq 0 ]; then
+    echo '>> All tests passed.'
+else
+    echo '>> Some tests failed.'
+fi
+exit $failed
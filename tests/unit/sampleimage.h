@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include <QImage>
+#include <QLinearGradient>
+#include <QPainter>
+
+/**
+ * @brief A deterministic image resembling a capture of a desktop: flat
+ * panels and thin lines as in user interfaces, a gradient, and a noisy area
+ * standing in for a photo.
+ */
+inline QImage sampleCapture(const QSize& size)
+{
+    QImage image(size, QImage::Format_RGB32);
+    image.fill(QColor(246, 245, 244));
+
+    QPainter painter(&image);
+    QLinearGradient gradient(0, 0, size.width(), size.height());
+    gradient.setColorAt(0, QColor(53, 132, 228));
+    gradient.setColorAt(1, QColor(224, 27, 36));
+    painter.fillRect(0, 0, size.width(), size.height() / 8, gradient);
+
+    const int step = qMax(16, size.width() / 24);
+    for (int y = size.height() / 8; y < size.height(); y += step * 2) {
+        for (int x = 0; x < size.width(); x += step * 3) {
+            painter.fillRect(x + 4,
+                             y + 4,
+                             step * 2,
+                             step,
+                             QColor::fromHsv((x / step * 37) % 360, 90, 220));
+            painter.setPen(QColor(40, 40, 40));
+            painter.drawLine(x + 8, y + step + 8, x + step * 2, y + step + 8);
+        }
+    }
+    painter.end();
+
+    // Noise from a linear congruential generator, the same on every run
+    quint32 seed = 1;
+    const QRect photo(size.width() / 2,
+                      size.height() / 2,
+                      size.width() / 4,
+                      size.height() / 4);
+    for (int y = photo.top(); y <= photo.bottom(); ++y) {
+        auto* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+        for (int x = photo.left(); x <= photo.right(); ++x) {
+            seed = seed * 1664525 + 1013904223;
+            line[x] = qRgb(x % 256, y % 256, seed >> 24);
+        }
+    }
+    return image;
+}
+
+/**
+ * @brief The largest difference of a color channel between two images of the
+ * same size, or -1 if their sizes differ.
+ */
+inline int maxChannelDifference(const QImage& a, const QImage& b)
+{
+    if (a.size() != b.size()) {
+        return -1;
+    }
+    const QImage first = a.convertToFormat(QImage::Format_RGB32);
+    const QImage second = b.convertToFormat(QImage::Format_RGB32);
+    int diff = 0;
+    for (int y = 0; y < first.height(); ++y) {
+        const auto* p = reinterpret_cast<const QRgb*>(first.constScanLine(y));
+        const auto* q = reinterpret_cast<const QRgb*>(second.constScanLine(y));
+        for (int x = 0; x < first.width(); ++x) {
+            diff = qMax(diff, qAbs(qRed(p[x]) - qRed(q[x])));
+            diff = qMax(diff, qAbs(qGreen(p[x]) - qGreen(q[x])));
+            diff = qMax(diff, qAbs(qBlue(p[x]) - qBlue(q[x])));
+        }
+    }
+    return diff;
+}
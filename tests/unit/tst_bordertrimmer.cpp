@@ -0,0 +1,125 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "src/utils/bordertrimmer.h"
+#include <QtTest>
+
+namespace {
+
+const QRgb background = qRgb(246, 245, 244);
+const QRgb content = qRgb(40, 40, 40);
+
+/**
+ * @brief An image of `size` filled with `border`, with each of `areas`
+ * filled with `fill`.
+ */
+QImage withContent(const QSize& size,
+                   const QVector<QRect>& areas,
+                   QImage::Format format = QImage::Format_RGB32,
+                   QRgb border = background,
+                   QRgb fill = content)
+{
+    QImage image(size, format);
+    image.fill(border);
+    for (const QRect& area : areas) {
+        for (int y = area.top(); y <= area.bottom(); ++y) {
+            for (int x = area.left(); x <= area.right(); ++x) {
+                image.setPixel(x, y, fill);
+            }
+        }
+    }
+    return image;
+}
+
+} // namespace
+
+class TestBorderTrimmer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void contentRect_data();
+    void contentRect();
+    void uniform();
+    void trimmed();
+};
+
+void TestBorderTrimmer::contentRect_data()
+{
+    QTest::addColumn<QImage>("image");
+    QTest::addColumn<QRect>("expected");
+
+    // Wider than a few blocks, and not a multiple of the block size
+    const QSize size(53, 37);
+    const QVector<QPoint> edges = {
+        { 20, 0 }, { 52, 11 }, { 7, 36 }, { 0, 25 }, { 52, 36 }, { 0, 36 }
+    };
+    const QStringList names = { "top edge",     "right edge",
+                                "bottom edge",  "left edge",
+                                "bottom right", "bottom left" };
+    for (int i = 0; i < edges.size(); ++i) {
+        QRect pixel(edges[i], QSize(1, 1));
+        QTest::newRow(qPrintable(names[i]))
+          << withContent(size, { pixel }) << pixel;
+    }
+
+    // The rows narrow the bounds found so far from both sides, and widen
+    // them again further down
+    QTest::newRow("narrowing rows")
+      << withContent(size, { QRect(30, 4, 1, 1), QRect(10, 9, 35, 1),
+                             QRect(20, 14, 5, 1), QRect(3, 20, 1, 1),
+                             QRect(49, 28, 1, 1) })
+      << QRect(QPoint(3, 4), QPoint(49, 28));
+    QTest::newRow("narrower than a block")
+      << withContent(QSize(100, 40), { QRect(61, 17, 5, 3) })
+      << QRect(61, 17, 5, 3);
+    QTest::newRow("narrower image than a block")
+      << withContent(QSize(9, 6), { QRect(2, 1, 3, 2) }) << QRect(2, 1, 3, 2);
+
+    // Only the alpha channel differs from the border
+    QTest::newRow("ARGB")
+      << withContent(size,
+                     { QRect(5, 6, 20, 10) },
+                     QImage::Format_ARGB32,
+                     qRgba(0, 0, 0, 0),
+                     qRgba(0, 0, 0, 128))
+      << QRect(5, 6, 20, 10);
+    QTest::newRow("premultiplied ARGB")
+      << withContent(size,
+                     { QRect(17, 30, 3, 2) },
+                     QImage::Format_ARGB32_Premultiplied,
+                     qRgba(0, 0, 0, 0),
+                     qRgba(64, 0, 0, 128))
+      << QRect(17, 30, 3, 2);
+}
+
+void TestBorderTrimmer::contentRect()
+{
+    QFETCH(QImage, image);
+    QFETCH(QRect, expected);
+
+    QCOMPARE(BorderTrimmer::contentRect(image), expected);
+}
+
+/**
+ * @brief A uniform image has no content, it is kept whole.
+ */
+void TestBorderTrimmer::uniform()
+{
+    const QImage image = withContent(QSize(53, 37), {});
+    QCOMPARE(BorderTrimmer::contentRect(image), image.rect());
+    QCOMPARE(BorderTrimmer::trimmed(image), image);
+}
+
+void TestBorderTrimmer::trimmed()
+{
+    const QRect area(10, 5, 7, 3);
+    const QImage image = withContent(QSize(40, 20), { area });
+    const QImage result = BorderTrimmer::trimmed(image);
+    QCOMPARE(result.size(), area.size());
+    QCOMPARE(result, image.copy(area));
+}
+
+QTEST_GUILESS_MAIN(TestBorderTrimmer)
+
+#include "tst_bordertrimmer.moc"
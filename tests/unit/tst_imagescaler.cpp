@@ -0,0 +1,80 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "src/utils/imagescaler.h"
+#include <QtTest>
+
+class TestImageScaler : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void flatStaysFlat_data();
+    void flatStaysFlat();
+    void fittedKeepsAspectRatio();
+};
+
+void TestImageScaler::flatStaysFlat_data()
+{
+    QTest::addColumn<int>("format");
+    QTest::addColumn<QRgb>("color");
+    QTest::addColumn<QSize>("size");
+
+    const int opaque = QImage::Format_RGB32;
+    const int alpha = QImage::Format_ARGB32;
+    QTest::newRow("half") << opaque << qRgb(12, 200, 90) << QSize(500, 350);
+    QTest::newRow("fractional") << opaque << qRgb(255, 255, 255)
+                                << QSize(333, 233);
+    QTest::newRow("one pixel less")
+      << opaque << qRgb(0, 0, 0) << QSize(999, 699);
+    QTest::newRow("eighth") << opaque << qRgb(1, 254, 128) << QSize(125, 87);
+    QTest::newRow("upscale") << opaque << qRgb(77, 77, 77)
+                             << QSize(1500, 1050);
+    QTest::newRow("translucent")
+      << alpha << qRgba(200, 100, 50, 128) << QSize(333, 233);
+}
+
+/**
+ * @brief The weights of each pixel add up to exactly one, so a flat image
+ * keeps its exact color, despite the negative lobes of the filter.
+ */
+void TestImageScaler::flatStaysFlat()
+{
+    QFETCH(int, format);
+    QFETCH(QRgb, color);
+    QFETCH(QSize, size);
+
+    QImage image(1000, 700, static_cast<QImage::Format>(format));
+    image.fill(QColor::fromRgba(color));
+    const QImage result = ImageScaler::scaled(image, size);
+    QCOMPARE(result.size(), size);
+
+    // The color as stored by the scaler, premultiplied if translucent
+    const QRgb expected = image.convertToFormat(result.format()).pixel(0, 0);
+    for (int y = 0; y < result.height(); ++y) {
+        for (int x = 0; x < result.width(); ++x) {
+            if (result.pixel(x, y) != expected) {
+                QFAIL(qPrintable(QStringLiteral("(%1, %2) is %3 instead of %4")
+                                   .arg(x)
+                                   .arg(y)
+                                   .arg(result.pixel(x, y), 8, 16)
+                                   .arg(expected, 8, 16)));
+            }
+        }
+    }
+}
+
+void TestImageScaler::fittedKeepsAspectRatio()
+{
+    QImage image(4000, 1000, QImage::Format_RGB32);
+    image.fill(Qt::gray);
+    QCOMPARE(ImageScaler::fitted(image, QSize(1000, 1000)).size(),
+             QSize(1000, 250));
+    // Images that already fit are returned as they are
+    QCOMPARE(ImageScaler::fitted(image, QSize(5000, 5000)).size(),
+             image.size());
+}
+
+QTEST_GUILESS_MAIN(TestImageScaler)
+
+#include "tst_imagescaler.moc"
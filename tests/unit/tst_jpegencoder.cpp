@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "src/utils/jpegencoder.h"
+#include "tests/unit/sampleimage.h"
+#include <QBuffer>
+#include <QImageWriter>
+#include <QThread>
+#include <QtTest>
+
+namespace {
+
+const int quality = 90;
+// Decoders may round the color conversion differently, a broken splice
+// shifts whole blocks by far more than this
+const int maxDifference = 4;
+
+QByteArray encode(const QImage& image)
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    JpegEncoder encoder(&buffer);
+    encoder.setQuality(quality);
+    if (!encoder.write(image)) {
+        return {};
+    }
+    return buffer.data();
+}
+
+QByteArray encodeWithQt(const QImage& image)
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    QImageWriter writer(&buffer, "jpeg");
+    writer.setQuality(quality);
+    if (!writer.write(image)) {
+        return {};
+    }
+    return buffer.data();
+}
+
+/**
+ * @brief Number of restart markers in `data`, which are the only markers
+ * that can appear within the entropy-coded data.
+ */
+int restartMarkers(const QByteArray& data)
+{
+    int count = 0;
+    for (int i = 0; i + 1 < data.size(); ++i) {
+        if (uchar(data[i]) == 0xff && uchar(data[i + 1]) >= 0xd0 &&
+            uchar(data[i + 1]) <= 0xd7) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+} // namespace
+
+class TestJpegEncoder : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void decodesLikeSingleStream_data();
+    void decodesLikeSingleStream();
+    void splitsTallImages();
+};
+
+void TestJpegEncoder::decodesLikeSingleStream_data()
+{
+    QTest::addColumn<QSize>("size");
+
+    QTest::newRow("full HD") << QSize(1920, 1080);
+    // The last MCU row and column are partial
+    QTest::newRow("partial MCUs") << QSize(1001, 777);
+    QTest::newRow("single stripe") << QSize(64, 16);
+}
+
+/**
+ * @brief The stripes joined with restart markers decode to the same pixels
+ * as the image encoded in one pass with the same tables.
+ */
+void TestJpegEncoder::decodesLikeSingleStream()
+{
+    QFETCH(QSize, size);
+    const QImage image = sampleCapture(size);
+
+    const QByteArray data = encode(image);
+    QVERIFY(!data.isEmpty());
+    const QImage decoded = QImage::fromData(data, "JPEG");
+    QCOMPARE(decoded.size(), size);
+
+    const QImage reference = QImage::fromData(encodeWithQt(image), "JPEG");
+    QCOMPARE(reference.size(), size);
+    int diff = maxChannelDifference(decoded, reference);
+    QVERIFY2(diff <= maxDifference, qPrintable(QString::number(diff)));
+}
+
+void TestJpegEncoder::splitsTallImages()
+{
+    if (QThread::idealThreadCount() < 2) {
+        QSKIP("The image is only split when several threads are available");
+    }
+    const QByteArray data = encode(sampleCapture(QSize(1920, 1080)));
+    QVERIFY(restartMarkers(data) > 0);
+}
+
+QTEST_GUILESS_MAIN(TestJpegEncoder)
+
+#include "tst_jpegencoder.moc"
@@ -0,0 +1,133 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "src/utils/palettequantizer.h"
+#include "tests/unit/sampleimage.h"
+#include <QtTest>
+
+namespace {
+
+// Quantizing the sample capture to 256 colors, on average per channel
+const double maxMeanDifference = 6;
+
+/**
+ * @brief An image of exactly `colors` distinct colors, each used several
+ * times and not in runs, translucent if `alpha`.
+ */
+QImage withColors(int colors, bool alpha)
+{
+    QImage image(64, 64, alpha ? QImage::Format_ARGB32 : QImage::Format_RGB32);
+    for (int y = 0; y < image.height(); ++y) {
+        for (int x = 0; x < image.width(); ++x) {
+            int i = (x * 7 + y * 13) % colors;
+            int a = alpha ? i % 200 + 10 : 255;
+            image.setPixel(
+              x, y, qRgba(i % 256, 255 - i % 256, i / 256 * 64, a));
+        }
+    }
+    return image;
+}
+
+/**
+ * @brief The mean difference of the color channels of two opaque images of
+ * the same size.
+ */
+double meanChannelDifference(const QImage& a, const QImage& b)
+{
+    const QImage first = a.convertToFormat(QImage::Format_RGB32);
+    const QImage second = b.convertToFormat(QImage::Format_RGB32);
+    qint64 sum = 0;
+    for (int y = 0; y < first.height(); ++y) {
+        const auto* p = reinterpret_cast<const QRgb*>(first.constScanLine(y));
+        const auto* q = reinterpret_cast<const QRgb*>(second.constScanLine(y));
+        for (int x = 0; x < first.width(); ++x) {
+            sum += qAbs(qRed(p[x]) - qRed(q[x])) +
+                   qAbs(qGreen(p[x]) - qGreen(q[x])) +
+                   qAbs(qBlue(p[x]) - qBlue(q[x]));
+        }
+    }
+    return double(sum) / (3.0 * first.width() * first.height());
+}
+
+} // namespace
+
+class TestPaletteQuantizer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void exact_data();
+    void exact();
+    void quantized_data();
+    void quantized();
+    void translucentManyColors();
+};
+
+void TestPaletteQuantizer::exact_data()
+{
+    QTest::addColumn<int>("colors");
+    QTest::addColumn<bool>("alpha");
+
+    QTest::newRow("one color") << 1 << false;
+    QTest::newRow("256 colors") << 256 << false;
+    QTest::newRow("256 translucent colors") << 256 << true;
+}
+
+/**
+ * @brief Images of at most 256 colors are converted losslessly, alpha
+ * included.
+ */
+void TestPaletteQuantizer::exact()
+{
+    QFETCH(int, colors);
+    QFETCH(bool, alpha);
+    const QImage image = withColors(colors, alpha);
+
+    const QImage indexed = PaletteQuantizer::toIndexed(image);
+    QCOMPARE(indexed.format(), QImage::Format_Indexed8);
+    QCOMPARE(indexed.colorCount(), colors);
+    QCOMPARE(indexed.convertToFormat(image.format()), image);
+}
+
+void TestPaletteQuantizer::quantized_data()
+{
+    QTest::addColumn<QImage>("image");
+
+    QTest::newRow("257 colors") << withColors(257, false);
+    QTest::newRow("sample capture") << sampleCapture(QSize(1920, 1080));
+}
+
+/**
+ * @brief Opaque images of more colors get a palette of at most 256 colors,
+ * close to the original.
+ */
+void TestPaletteQuantizer::quantized()
+{
+    QFETCH(QImage, image);
+
+    const QImage indexed = PaletteQuantizer::toIndexed(image);
+    QCOMPARE(indexed.format(), QImage::Format_Indexed8);
+    QCOMPARE(indexed.size(), image.size());
+    QVERIFY(indexed.colorCount() > 0);
+    QVERIFY(indexed.colorCount() <= 256);
+    double diff = meanChannelDifference(indexed, image);
+    QVERIFY2(diff <= maxMeanDifference, qPrintable(QString::number(diff)));
+}
+
+/**
+ * @brief Translucent images of more than 256 colors can't be indexed, the
+ * palette doesn't model alpha.
+ */
+void TestPaletteQuantizer::translucentManyColors()
+{
+    QVERIFY(PaletteQuantizer::toIndexed(withColors(257, true)).isNull());
+
+    QImage image = sampleCapture(QSize(640, 480))
+                     .convertToFormat(QImage::Format_ARGB32);
+    image.setPixel(0, 0, qRgba(0, 0, 0, 128));
+    QVERIFY(PaletteQuantizer::toIndexed(image).isNull());
+}
+
+QTEST_GUILESS_MAIN(TestPaletteQuantizer)
+
+#include "tst_palettequantizer.moc"
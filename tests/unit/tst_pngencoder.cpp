@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "src/utils/pngencoder.h"
+#include "tests/unit/sampleimage.h"
+#include <QBuffer>
+#include <QtTest>
+
+namespace {
+
+QImage translucentImage(const QSize& size)
+{
+    QImage image(size, QImage::Format_ARGB32);
+    for (int y = 0; y < size.height(); ++y) {
+        auto* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+        for (int x = 0; x < size.width(); ++x) {
+            line[x] = qRgba(x % 256, y % 256, (x + y) % 256, (x * y) % 256);
+        }
+    }
+    return image;
+}
+
+} // namespace
+
+class TestPngEncoder : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void roundTrip_data();
+    void roundTrip();
+};
+
+void TestPngEncoder::roundTrip_data()
+{
+    QTest::addColumn<QImage>("image");
+    QTest::addColumn<int>("level");
+    QTest::addColumn<bool>("fast");
+
+    const QImage capture = sampleCapture(QSize(1920, 1080));
+    QTest::newRow("adaptive") << capture << 6 << false;
+    QTest::newRow("fast") << capture << 6 << true;
+    QTest::newRow("stored") << capture << 0 << false;
+    QTest::newRow("best") << capture << 9 << false;
+    // Many more strips than threads, each a few rows high
+    QTest::newRow("tall") << sampleCapture(QSize(37, 4000)) << 6 << false;
+    QTest::newRow("translucent")
+      << translucentImage(QSize(701, 503)) << 6 << false;
+    QTest::newRow("one pixel") << sampleCapture(QSize(1, 1)) << 6 << false;
+}
+
+/**
+ * @brief The strips deflated in parallel make a valid PNG that Qt decodes to
+ * the exact same pixels.
+ */
+void TestPngEncoder::roundTrip()
+{
+    QFETCH(QImage, image);
+    QFETCH(int, level);
+    QFETCH(bool, fast);
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    PngEncoder encoder(&buffer);
+    encoder.setCompressionLevel(level);
+    encoder.setFilter(fast ? PngEncoder::Fast : PngEncoder::Adaptive);
+    QVERIFY2(encoder.write(image), qPrintable(encoder.errorString()));
+
+    const QImage decoded = QImage::fromData(buffer.data(), "PNG");
+    QVERIFY(!decoded.isNull());
+    QCOMPARE(decoded.hasAlphaChannel(), image.hasAlphaChannel());
+    QCOMPARE(decoded.convertToFormat(QImage::Format_ARGB32),
+             image.convertToFormat(QImage::Format_ARGB32));
+}
+
+QTEST_GUILESS_MAIN(TestPngEncoder)
+
+#include "tst_pngencoder.moc"
@@ -0,0 +1,176 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "src/utils/ppmreader.h"
+#include <QtTest>
+#include <climits>
+#include <cstring>
+
+namespace {
+
+/**
+ * @brief A pipe-like device: only the bytes made available so far can be
+ * read, as if the rest was not written by the producer yet.
+ */
+class ChunkedDevice : public QIODevice
+{
+public:
+    explicit ChunkedDevice(const QByteArray& data)
+      : m_data(data)
+      , m_available(0)
+      , m_pos(0)
+    {
+        open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+    }
+
+    void makeAvailable(int size) { m_available = qMin(size, m_data.size()); }
+
+    bool isSequential() const override { return true; }
+
+    qint64 bytesAvailable() const override
+    {
+        return m_available - m_pos + QIODevice::bytesAvailable();
+    }
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override
+    {
+        qint64 count = qMin<qint64>(maxSize, m_available - m_pos);
+        memcpy(data, m_data.constData() + m_pos, count);
+        m_pos += static_cast<int>(count);
+        return count;
+    }
+
+    qint64 writeData(const char*, qint64) override { return -1; }
+
+private:
+    QByteArray m_data;
+    int m_available;
+    int m_pos;
+};
+
+// The pixels start with bytes that are whitespace, which must not be taken
+// for the end of the header
+const char pixels[] = "\n \t\r"
+                      "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                      "0123456789!?";
+const int width = 6;
+const int height = 4;
+static_assert(sizeof(pixels) - 1 == width * height * 3, "6x4 RGB pixels");
+
+QImage expectedImage()
+{
+    QImage image(width, height, QImage::Format_RGB888);
+    for (int y = 0; y < height; ++y) {
+        memcpy(image.scanLine(y), pixels + y * width * 3, width * 3);
+    }
+    return image;
+}
+
+QByteArray ppm(const QByteArray& header)
+{
+    return header + QByteArray(pixels, width * height * 3);
+}
+
+} // namespace
+
+class TestPpmReader : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void splitOnce_data();
+    void splitOnce();
+    void byteByByte();
+    void comment();
+    void rejects_data();
+    void rejects();
+};
+
+void TestPpmReader::splitOnce_data()
+{
+    QTest::addColumn<int>("split");
+
+    const QByteArray header = "P6\n6 4\n255\n";
+    for (int split = 0; split <= header.size() + 1; ++split) {
+        QTest::addRow("at %d", split) << split;
+    }
+    // Within the rows, and at the end of one
+    QTest::newRow("mid row") << header.size() + 5;
+    QTest::newRow("end of row") << header.size() + width * 3;
+}
+
+/**
+ * @brief The stream is only available up to `split` at first, as when the
+ * producer is still writing it, then entirely. This covers each boundary of
+ * the header, around maxval and its single trailing whitespace in
+ * particular.
+ */
+void TestPpmReader::splitOnce()
+{
+    QFETCH(int, split);
+
+    ChunkedDevice device(ppm("P6\n6 4\n255\n"));
+    PpmReader reader;
+    device.makeAvailable(split);
+    QVERIFY(reader.read(&device));
+    QVERIFY(!reader.isComplete());
+    QVERIFY(reader.image().isNull());
+
+    device.makeAvailable(INT_MAX);
+    QVERIFY(reader.read(&device));
+    QVERIFY(reader.isComplete());
+    QCOMPARE(reader.image(), expectedImage());
+}
+
+void TestPpmReader::byteByByte()
+{
+    const QByteArray data = ppm("P6 6  4\t255 ");
+    ChunkedDevice device(data);
+    PpmReader reader;
+    for (int size = 1; size <= data.size(); ++size) {
+        device.makeAvailable(size);
+        QVERIFY(reader.read(&device));
+        QCOMPARE(reader.isComplete(), size == data.size());
+    }
+    QCOMPARE(reader.image(), expectedImage());
+}
+
+void TestPpmReader::comment()
+{
+    const QByteArray data = ppm("P6\n# CREATOR: grim\n6 4\n255\n");
+    ChunkedDevice device(data);
+    PpmReader reader;
+    // Split within the comment
+    device.makeAvailable(8);
+    QVERIFY(reader.read(&device));
+    device.makeAvailable(data.size());
+    QVERIFY(reader.read(&device));
+    QCOMPARE(reader.image(), expectedImage());
+}
+
+void TestPpmReader::rejects_data()
+{
+    QTest::addColumn<QByteArray>("header");
+
+    QTest::newRow("ASCII PPM") << QByteArray("P3\n6 4\n255\n");
+    QTest::newRow("16 bits per sample") << QByteArray("P6\n6 4\n65535\n");
+    QTest::newRow("zero width") << QByteArray("P6\n0 4\n255\n");
+    QTest::newRow("not a number") << QByteArray("P6\n6 x\n255\n");
+}
+
+void TestPpmReader::rejects()
+{
+    QFETCH(QByteArray, header);
+
+    ChunkedDevice device(ppm(header));
+    device.makeAvailable(INT_MAX);
+    PpmReader reader;
+    QVERIFY(!reader.read(&device));
+    QVERIFY(reader.hasError());
+    QVERIFY(reader.image().isNull());
+}
+
+QTEST_GUILESS_MAIN(TestPpmReader)
+
+#include "tst_ppmreader.moc"
@@ -0,0 +1,144 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "src/utils/qoihandler.h"
+#include "tests/unit/sampleimage.h"
+#include <QBuffer>
+#include <QtTest>
+#include <algorithm>
+
+namespace {
+
+const int headerSize = 14;
+const QByteArray endMarker("\0\0\0\0\0\0\0\1", 8);
+
+QByteArray encode(const QImage& image)
+{
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    QoiHandler handler;
+    handler.setDevice(&buffer);
+    return handler.write(image) ? data : QByteArray();
+}
+
+QImage decode(const QByteArray& data)
+{
+    QBuffer buffer;
+    buffer.setData(data);
+    buffer.open(QIODevice::ReadOnly);
+    QoiHandler handler;
+    handler.setDevice(&buffer);
+    QImage image;
+    return handler.read(&image) ? image : QImage();
+}
+
+/**
+ * @brief A single row of `pixels`, translucent if any of them is.
+ */
+QImage row(const QVector<QRgb>& pixels)
+{
+    bool alpha = std::any_of(pixels.begin(), pixels.end(), [](QRgb px) {
+        return qAlpha(px) != 255;
+    });
+    QImage image(pixels.size(),
+                 1,
+                 alpha ? QImage::Format_ARGB32 : QImage::Format_RGB32);
+    for (int x = 0; x < pixels.size(); ++x) {
+        image.setPixel(x, 0, pixels[x]);
+    }
+    return image;
+}
+
+QImage translucentGradient(const QSize& size)
+{
+    QImage image(size, QImage::Format_ARGB32);
+    for (int y = 0; y < size.height(); ++y) {
+        for (int x = 0; x < size.width(); ++x) {
+            image.setPixel(x, y, qRgba(x % 256, y % 256, 128, (x + y) % 256));
+        }
+    }
+    return image;
+}
+
+} // namespace
+
+class TestQoiHandler : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void ops_data();
+    void ops();
+    void roundTrip_data();
+    void roundTrip();
+};
+
+void TestQoiHandler::ops_data()
+{
+    QTest::addColumn<QImage>("image");
+    QTest::addColumn<QByteArray>("body");
+
+    // Runs are limited to 62 pixels, the previous pixel starts as opaque
+    // black
+    QVector<QRgb> black(100, qRgb(0, 0, 0));
+    QTest::newRow("run") << row(black) << QByteArray("\xfd\xe5");
+    // Differences of -2 to 1 on each channel, with wraparound
+    QTest::newRow("diff") << row({ qRgb(1, 255, 0) }) << QByteArray("\x76");
+    // Green within -32 to 31, red and blue within -8 to 7 of it
+    QTest::newRow("luma") << row({ qRgb(20, 25, 18) })
+                          << QByteArray("\xb9\x31");
+    // The third pixel was seen before, at position 13 of the index
+    QTest::newRow("rgb and index")
+      << row({ qRgb(10, 200, 30), qRgb(200, 10, 90), qRgb(10, 200, 30) })
+      << QByteArray("\xfe\x0a\xc8\x1e\xfe\xc8\x0a\x5a\x0d");
+    // Any change of alpha
+    QTest::newRow("rgba") << row({ qRgba(10, 20, 30, 128) })
+                          << QByteArray("\xff\x0a\x14\x1e\x80");
+}
+
+/**
+ * @brief Each op is encoded as in the specification and decoded back.
+ */
+void TestQoiHandler::ops()
+{
+    QFETCH(QImage, image);
+    QFETCH(QByteArray, body);
+
+    const QByteArray data = encode(image);
+    QCOMPARE(data.mid(headerSize, data.size() - headerSize - 8), body);
+    QVERIFY(data.endsWith(endMarker));
+    QCOMPARE(int(data[12]), image.hasAlphaChannel() ? 4 : 3);
+
+    const QImage decoded = decode(data);
+    QCOMPARE(decoded.convertToFormat(QImage::Format_ARGB32),
+             image.convertToFormat(QImage::Format_ARGB32));
+}
+
+void TestQoiHandler::roundTrip_data()
+{
+    QTest::addColumn<QImage>("image");
+
+    QTest::newRow("capture") << sampleCapture(QSize(1920, 1080));
+    QTest::newRow("translucent") << translucentGradient(QSize(300, 200));
+    // Runs continue on the next row
+    QImage flat(100, 3, QImage::Format_RGB32);
+    flat.fill(qRgb(40, 40, 40));
+    QTest::newRow("run across rows") << flat;
+    QTest::newRow("one pixel") << row({ qRgba(1, 2, 3, 4) });
+}
+
+void TestQoiHandler::roundTrip()
+{
+    QFETCH(QImage, image);
+
+    const QImage decoded = decode(encode(image));
+    QCOMPARE(decoded.size(), image.size());
+    QCOMPARE(decoded.hasAlphaChannel(), image.hasAlphaChannel());
+    QCOMPARE(decoded.convertToFormat(QImage::Format_ARGB32),
+             image.convertToFormat(QImage::Format_ARGB32));
+}
+
+QTEST_GUILESS_MAIN(TestQoiHandler)
+
+#include "tst_qoihandler.moc"
@@ -0,0 +1,99 @@
+#!/usr/bin/env sh
+
+# Tests for the built-in wlroots screencopy backend against a headless sway
+# Arguments:
+# 1. path to tested flameshot executable (built with USE_WAYLAND_SCREENCOPY)
+
+# Dependencies:
+# - sway (wlroots with the headless backend and the pixman renderer)
+# - grim, to compare against the fallback capture path
+# - convert, identify and compare (imagemagick)
+
+# HOW TO USE:
+# - Start the script with path to tested flameshot executable as the first
+#   argument. No running Wayland session is needed.
+# - The size of each capture is checked against the output layout below and
+#   its pixels against the capture taken by grim. The script exits with an
+#   error if any check failed.
+
+[ -n "$1" ] && flameshot="$1" || flameshot='flameshot'
+
+runtime_dir=$(mktemp -d)
+config="$runtime_dir/sway.conf"
+# A gradient wallpaper, so that a blank capture or one of the wrong area
+# doesn't pass
+convert -size 256x256 gradient:red-blue "$runtime_dir/background.png"
+cat >"$config" <<EOF
+output * bg $runtime_dir/background.png tile
+output HEADLESS-1 resolution 1920x1080 position 0 0
+output HEADLESS-2 resolution 1280x1024 position 1920 0 scale 2
+EOF
+
+export XDG_RUNTIME_DIR="$runtime_dir"
+export WLR_BACKENDS=headless
+export WLR_RENDERER=pixman
+export WLR_LIBINPUT_NO_DEVICES=1
+export WLR_HEADLESS_OUTPUTS=2
+sway -c "$config" >"$runtime_dir/sway.log" 2>&1 &
+sway_pid=$!
+trap 'kill $sway_pid; rm -rf "$runtime_dir"' EXIT
+sleep 2
+
+export WAYLAND_DISPLAY=wayland-1
+export XDG_CURRENT_DESKTOP=sway
+export QT_QPA_PLATFORM=wayland
+
+failed=0
+
+# Check that the image $1 is $2 (WxH) pixels and not of a single color
+check_image() {
+    size=$(identify -format "%wx%h" "$1")
+    colors=$(identify -format "%k" "$1")
+    if [ "$size" != "$2" ]; then
+        echo "FAIL: $1 is $size instead of $2"
+        failed=1
+    elif [ "${colors:-0}" -le 1 ]; then
+        echo "FAIL: $1 is uniform"
+        failed=1
+    else
+        echo "OK:   $1 is $size with $colors colors"
+    fi
+}
+
+# Check that the images $1 and $2 have the same pixels
+check_same() {
+    diff=$(compare -metric AE "$1" "$2" null: 2>&1)
+    if [ "$diff" != "0" ]; then
+        echo "FAIL: $1 differs from $2 ($diff pixels)"
+        failed=1
+    else
+        echo "OK:   $1 matches $2"
+    fi
+}
+
+# The layout is 1920x1080 and 640x512 logical pixels side by side, composed
+# at the scale of HEADLESS-2
+echo ">> Full desktop, both outputs composed at the highest scale"
+"$flameshot" full --raw >"$runtime_dir/flameshot.png"
+grim "$runtime_dir/grim.png"
+check_image "$runtime_dir/flameshot.png" 5120x2160
+check_same "$runtime_dir/flameshot.png" "$runtime_dir/grim.png"
+
+echo ">> Single screen"
+"$flameshot" screen -n 0 --raw >"$runtime_dir/flameshot_screen.png"
+grim -o HEADLESS-1 "$runtime_dir/grim_screen.png"
+check_image "$runtime_dir/flameshot_screen.png" 1920x1080
+check_same "$runtime_dir/flameshot_screen.png" "$runtime_dir/grim_screen.png"
+
+echo ">> Scaled screen"
+"$flameshot" screen -n 1 --raw >"$runtime_dir/flameshot_scaled.png"
+grim -o HEADLESS-2 "$runtime_dir/grim_scaled.png"
+check_image "$runtime_dir/flameshot_scaled.png" 1280x1024
+check_same "$runtime_dir/flameshot_scaled.png" "$runtime_dir/grim_scaled.png"
+
+if [ $failed -eq 0 ]; then
+    echo '>> All tests passed.'
+else
+    echo '>> Some tests failed.'
+fi
+exit $failed